@@ -0,0 +1,220 @@
+#include "Parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+// TaskGraph implementations
+// -------------------------
+// 一次 Execute 的运行状态。每个就绪的任务都会向线程池提交一张执行票，调用线程也会领取就绪任务，
+// 先领到的执行，领不到的执行票直接返回，因此 Execute 返回后才开始的执行票不会访问任务图
+struct FTaskGraph::FExecutionState
+{
+    std::vector<FNode>*                          Nodes{ nullptr };
+    FThreadPool*                                 ThreadPool{ nullptr };
+    std::mutex                                   Mutex;
+    std::condition_variable                      Condition;
+    std::vector<FTaskId>                         ReadyTasks;
+    std::unique_ptr<std::atomic<std::size_t>[]> PendingCounts;
+    std::size_t                                  RemainingCount{};
+    std::exception_ptr                           Exception;
+};
+
+FTaskGraph::FTaskId FTaskGraph::AddTask(std::function<void()>&& Task)
+{
+    _Nodes.push_back({ std::move(Task), {}, 0 });
+    return _Nodes.size() - 1;
+}
+
+void FTaskGraph::AddDependency(FTaskId Predecessor, FTaskId Successor)
+{
+    if (Predecessor >= _Nodes.size() || Successor >= _Nodes.size())
+    {
+        throw std::out_of_range("Task id out of range.");
+    }
+
+    _Nodes[Predecessor].Successors.push_back(Successor);
+    ++_Nodes[Successor].PredecessorCount;
+}
+
+void FTaskGraph::Execute(FThreadPool* ThreadPool)
+{
+    if (_Nodes.empty())
+    {
+        return;
+    }
+
+    // 先按拓扑序检查一遍，有环时任务永远无法全部就绪
+    {
+        std::vector<std::size_t> PendingCounts(_Nodes.size());
+        std::vector<FTaskId>     Queue;
+        for (FTaskId Id = 0; Id != _Nodes.size(); ++Id)
+        {
+            PendingCounts[Id] = _Nodes[Id].PredecessorCount;
+            if (PendingCounts[Id] == 0)
+            {
+                Queue.push_back(Id);
+            }
+        }
+
+        std::size_t VisitedCount = 0;
+        while (!Queue.empty())
+        {
+            FTaskId Id = Queue.back();
+            Queue.pop_back();
+            ++VisitedCount;
+            for (FTaskId Successor : _Nodes[Id].Successors)
+            {
+                if (--PendingCounts[Successor] == 0)
+                {
+                    Queue.push_back(Successor);
+                }
+            }
+        }
+
+        if (VisitedCount != _Nodes.size())
+        {
+            throw std::logic_error("Task graph contains a cycle.");
+        }
+    }
+
+    auto State = std::make_shared<FExecutionState>();
+    State->Nodes          = &_Nodes;
+    State->ThreadPool     = ThreadPool;
+    State->PendingCounts  = std::make_unique<std::atomic<std::size_t>[]>(_Nodes.size());
+    State->RemainingCount = _Nodes.size();
+    for (FTaskId Id = 0; Id != _Nodes.size(); ++Id)
+    {
+        State->PendingCounts[Id].store(_Nodes[Id].PredecessorCount, std::memory_order_relaxed);
+    }
+
+    std::size_t RootCount = 0;
+    {
+        std::lock_guard<std::mutex> Lock(State->Mutex);
+        for (FTaskId Id = 0; Id != _Nodes.size(); ++Id)
+        {
+            if (_Nodes[Id].PredecessorCount == 0)
+            {
+                State->ReadyTasks.push_back(Id);
+                ++RootCount;
+            }
+        }
+    }
+
+    // 调用线程自己也会领取任务，少提交一张执行票
+    for (std::size_t i = 1; i < RootCount; ++i)
+    {
+        SubmitTicket(State);
+    }
+
+    while (true)
+    {
+        FTaskId TaskId = 0;
+        {
+            std::unique_lock<std::mutex> Lock(State->Mutex);
+            State->Condition.wait(Lock, [&State]() -> bool
+            {
+                return !State->ReadyTasks.empty() || State->RemainingCount == 0;
+            });
+
+            if (State->RemainingCount == 0)
+            {
+                break;
+            }
+
+            TaskId = State->ReadyTasks.back();
+            State->ReadyTasks.pop_back();
+        }
+
+        RunTask(State, TaskId);
+    }
+
+    if (State->Exception != nullptr)
+    {
+        std::rethrow_exception(State->Exception);
+    }
+}
+
+void FTaskGraph::Clear()
+{
+    _Nodes.clear();
+}
+
+void FTaskGraph::RunTask(const std::shared_ptr<FExecutionState>& State, FTaskId TaskId)
+{
+    auto& Node = (*State->Nodes)[TaskId];
+
+    bool bFailed = false;
+    {
+        std::lock_guard<std::mutex> Lock(State->Mutex);
+        bFailed = State->Exception != nullptr;
+    }
+
+    // 出错后不再执行后续任务，但依然释放依赖，保证 Execute 能够返回
+    if (!bFailed)
+    {
+        try
+        {
+            Node.Task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> Lock(State->Mutex);
+            if (State->Exception == nullptr)
+            {
+                State->Exception = std::current_exception();
+            }
+        }
+    }
+
+    for (FTaskId Successor : Node.Successors)
+    {
+        if (State->PendingCounts[Successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            {
+                std::lock_guard<std::mutex> Lock(State->Mutex);
+                State->ReadyTasks.push_back(Successor);
+            }
+            SubmitTicket(State);
+        }
+    }
+
+    // 计数归零后调用线程可能立即返回并销毁任务图，此后不能再访问 Node
+    {
+        std::lock_guard<std::mutex> Lock(State->Mutex);
+        --State->RemainingCount;
+    }
+    State->Condition.notify_all();
+}
+
+void FTaskGraph::SubmitTicket(const std::shared_ptr<FExecutionState>& State)
+{
+    State->ThreadPool->Dispatch([State]() -> void
+    {
+        FTaskId TaskId = 0;
+        {
+            std::lock_guard<std::mutex> Lock(State->Mutex);
+            if (State->ReadyTasks.empty())
+            {
+                return;
+            }
+
+            TaskId = State->ReadyTasks.back();
+            State->ReadyTasks.pop_back();
+        }
+
+        RunTask(State, TaskId);
+    });
+}
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
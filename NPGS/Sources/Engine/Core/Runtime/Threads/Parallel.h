@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+#include "ThreadPool.h"
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+// 动态分块的并行循环。调用线程和最多 MaxThread - 1 个线程池任务共同从 [0, Count) 中领取区间，
+// 每次领取剩余量的一部分（不少于 MinChunkSize），开销大的元素不会让其他线程空等
+// Pred 的签名为 void(int ThreadId, std::size_t Begin, std::size_t End)，ThreadId 在 [0, MaxThread) 内，
+// 同一个 ThreadId 的调用不会并发，可以用来索引每个线程独占的状态。调用线程不会等待尚未开始的任务，可以嵌套使用
+template <typename Func>
+void ParallelFor(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, Func&& Pred, std::size_t MinChunkSize = 1);
+
+// 把 [0, Count) 均分为 MaxThread 个固定的连续区间，Pred 的 ThreadId 即区间序号
+// 区间划分与线程数以外的因素无关，适合按区间保存局部结果、再按区间顺序合并的确定性算法
+template <typename Func>
+void ForEachThreadRange(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, Func&& Pred);
+
+// 基于 ParallelFor 的归约。每个线程从 Identity 开始用 Pred(ValueType& Local, Begin, End) 累积，
+// 最后按 ThreadId 顺序用 Combine(ValueType, ValueType) 合并。区间的分配不固定，Combine 需要满足交换律和结合律
+template <typename ValueType, typename Func, typename CombineFunc>
+ValueType ParallelReduce(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, ValueType Identity,
+                         Func&& Pred, CombineFunc&& Combine, std::size_t MinChunkSize = 1);
+
+// 任务依赖图。前驱全部完成后任务才会被提交到线程池，没有依赖关系的任务可以同时运行，不再需要阶段之间的全屏障
+// Execute 时调用线程也参与执行就绪的任务，任务抛出的第一个异常会在 Execute 中重新抛出，之后的任务不再执行
+class FTaskGraph
+{
+public:
+    using FTaskId = std::size_t;
+
+public:
+    FTaskGraph()  = default;
+    ~FTaskGraph() = default;
+
+    FTaskId AddTask(std::function<void()>&& Task);
+    void AddDependency(FTaskId Predecessor, FTaskId Successor);
+    void Execute(FThreadPool* ThreadPool);
+    void Clear();
+
+private:
+    struct FNode
+    {
+        std::function<void()> Task;
+        std::vector<FTaskId>  Successors;
+        std::size_t           PredecessorCount{};
+    };
+
+    struct FExecutionState;
+
+private:
+    static void RunTask(const std::shared_ptr<FExecutionState>& State, FTaskId TaskId);
+    static void SubmitTicket(const std::shared_ptr<FExecutionState>& State);
+
+private:
+    std::vector<FNode> _Nodes;
+};
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
+
+#include "Parallel.inl"
@@ -0,0 +1,151 @@
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+template <typename Func>
+inline void ParallelFor(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, Func&& Pred, std::size_t MinChunkSize)
+{
+    MaxThread    = std::max(MaxThread, 1);
+    MinChunkSize = std::max(MinChunkSize, static_cast<std::size_t>(1));
+
+    if (Count == 0)
+    {
+        return;
+    }
+
+    if (MaxThread == 1 || Count <= MinChunkSize)
+    {
+        Pred(0, static_cast<std::size_t>(0), Count);
+        return;
+    }
+
+    // 共享状态由调用线程和辅助任务共同持有。调用线程返回后才开始的任务只会看到已经领完的区间，不会访问 Pred
+    struct FState
+    {
+        std::atomic<std::size_t> NextIndex{ 0 };
+        std::atomic<int>         ActiveCount{ 0 };
+        std::atomic<bool>        bFailed{ false };
+        std::exception_ptr       Exception;
+    };
+
+    auto  State     = std::make_shared<FState>();
+    auto* Predicate = &Pred;
+    std::size_t Divisor = static_cast<std::size_t>(MaxThread) * 4;
+
+    // 先登记为活跃再检查剩余量，与调用线程先领完再检查活跃数的顺序配对，两边都是顺序一致的原子操作
+    auto Run = [State, Predicate, Count, MinChunkSize, Divisor](int ThreadId) -> void
+    {
+        State->ActiveCount.fetch_add(1);
+        while (true)
+        {
+            std::size_t Current = State->NextIndex.load();
+            if (Current >= Count)
+            {
+                break;
+            }
+
+            std::size_t ChunkSize = std::max((Count - Current) / Divisor, MinChunkSize);
+            std::size_t Begin     = State->NextIndex.fetch_add(ChunkSize);
+            if (Begin >= Count)
+            {
+                break;
+            }
+
+            try
+            {
+                (*Predicate)(ThreadId, Begin, std::min(Begin + ChunkSize, Count));
+            }
+            catch (...)
+            {
+                if (!State->bFailed.exchange(true))
+                {
+                    State->Exception = std::current_exception();
+                }
+
+                State->NextIndex.store(Count);
+            }
+        }
+        if (State->ActiveCount.fetch_sub(1) == 1)
+        {
+            State->ActiveCount.notify_all();
+        }
+    };
+
+    for (int i = 1; i != MaxThread; ++i)
+    {
+        ThreadPool->Dispatch([Run, i]() -> void { Run(i); });
+    }
+
+    Run(0);
+
+    // 区间已经领完，只需等待正在执行最后一块的线程。最后几块通常很快结束，先短暂让出，之后阻塞等待，不再占用核心
+    constexpr int kSpinCount = 64;
+    for (int Spin = 0; Spin != kSpinCount && State->ActiveCount.load() != 0; ++Spin)
+    {
+        std::this_thread::yield();
+    }
+
+    for (int ActiveCount = State->ActiveCount.load(); ActiveCount != 0; ActiveCount = State->ActiveCount.load())
+    {
+        State->ActiveCount.wait(ActiveCount);
+    }
+
+    if (State->Exception != nullptr)
+    {
+        std::rethrow_exception(State->Exception);
+    }
+}
+
+template <typename Func>
+inline void ForEachThreadRange(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, Func&& Pred)
+{
+    MaxThread = std::max(MaxThread, 1);
+
+    // 对区间序号做 ParallelFor，每个区间只会被一个线程领取
+    std::size_t ChunkSize = (Count + MaxThread - 1) / MaxThread;
+    ParallelFor(ThreadPool, MaxThread, static_cast<std::size_t>(MaxThread),
+    [&](int, std::size_t FirstRange, std::size_t LastRange) -> void
+    {
+        for (std::size_t Range = FirstRange; Range != LastRange; ++Range)
+        {
+            std::size_t Begin = std::min(Range * ChunkSize, Count);
+            std::size_t End   = std::min(Begin + ChunkSize, Count);
+            Pred(static_cast<int>(Range), Begin, End);
+        }
+    });
+}
+
+template <typename ValueType, typename Func, typename CombineFunc>
+inline ValueType ParallelReduce(FThreadPool* ThreadPool, int MaxThread, std::size_t Count, ValueType Identity,
+                                Func&& Pred, CombineFunc&& Combine, std::size_t MinChunkSize)
+{
+    MaxThread = std::max(MaxThread, 1);
+
+    std::vector<ValueType> LocalValues(MaxThread, Identity);
+    ParallelFor(ThreadPool, MaxThread, Count, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+    {
+        Pred(LocalValues[ThreadId], Begin, End);
+    }, MinChunkSize);
+
+    ValueType Result = std::move(LocalValues.front());
+    for (int i = 1; i != MaxThread; ++i)
+    {
+        Result = Combine(std::move(Result), std::move(LocalValues[i]));
+    }
+
+    return Result;
+}
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
@@ -0,0 +1,202 @@
+#include "Task.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <vector>
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+namespace
+{
+    using FBlockList = std::vector<void*>;
+
+    // 所有线程共享的中心缓存，线程缓存为空或溢出时与它成批交换。块在一个线程分配、在另一个线程释放时，
+    // 经由中心缓存回到分配的线程，外部线程提交、工作线程执行的任务稳定运行后也不会访问堆
+    struct FSharedBlockCache
+    {
+        std::array<FBlockList, FTaskBlockPool::kSizeClassCount> FreeBlocks;
+        std::array<std::mutex, FTaskBlockPool::kSizeClassCount> Mutexes;
+
+        ~FSharedBlockCache();
+    };
+
+    struct FBlockCache
+    {
+        std::array<FBlockList, FTaskBlockPool::kSizeClassCount> FreeBlocks;
+
+        ~FBlockCache();
+    };
+
+    // 中心缓存是常量初始化的，先于任何线程缓存构造，在线程池的工作线程结束之后销毁
+    // 缓存销毁之后释放的块直接归还给堆。标志是平凡类型，销毁后依然可以读取
+    bool                     kbSharedCacheDestroyed = false;
+    FSharedBlockCache        kSharedBlockCache;
+    thread_local bool        kbCacheDestroyed = false;
+    thread_local FBlockCache kBlockCache;
+
+    FSharedBlockCache::~FSharedBlockCache()
+    {
+        kbSharedCacheDestroyed = true;
+        for (auto& Blocks : FreeBlocks)
+        {
+            for (void* Block : Blocks)
+            {
+                ::operator delete(Block);
+            }
+        }
+    }
+
+    // 从中心缓存取走最多 kTransferBatchSize 个块
+    void RefillBlocks(std::size_t SizeClass, FBlockList& Blocks)
+    {
+        if (kbSharedCacheDestroyed)
+        {
+            return;
+        }
+
+        auto& SharedBlocks = kSharedBlockCache.FreeBlocks[SizeClass];
+        std::lock_guard<std::mutex> Lock(kSharedBlockCache.Mutexes[SizeClass]);
+        std::size_t Count = std::min(SharedBlocks.size(), FTaskBlockPool::kTransferBatchSize);
+        Blocks.insert(Blocks.end(), SharedBlocks.end() - Count, SharedBlocks.end());
+        SharedBlocks.resize(SharedBlocks.size() - Count);
+    }
+
+    // 把线程缓存末尾的 Count 个块交给中心缓存
+    void FlushBlocks(std::size_t SizeClass, FBlockList& Blocks, std::size_t Count)
+    {
+        if (kbSharedCacheDestroyed)
+        {
+            for (std::size_t i = Blocks.size() - Count; i != Blocks.size(); ++i)
+            {
+                ::operator delete(Blocks[i]);
+            }
+        }
+        else
+        {
+            auto& SharedBlocks = kSharedBlockCache.FreeBlocks[SizeClass];
+            std::lock_guard<std::mutex> Lock(kSharedBlockCache.Mutexes[SizeClass]);
+            SharedBlocks.insert(SharedBlocks.end(), Blocks.end() - Count, Blocks.end());
+        }
+
+        Blocks.resize(Blocks.size() - Count);
+    }
+
+    FBlockCache::~FBlockCache()
+    {
+        kbCacheDestroyed = true;
+        for (std::size_t SizeClass = 0; SizeClass != FTaskBlockPool::kSizeClassCount; ++SizeClass)
+        {
+            FlushBlocks(SizeClass, FreeBlocks[SizeClass], FreeBlocks[SizeClass].size());
+        }
+    }
+
+    std::size_t GetSizeClass(std::size_t Size)
+    {
+        return (Size + FTaskBlockPool::kBlockGranularity - 1) / FTaskBlockPool::kBlockGranularity - 1;
+    }
+}
+
+// FTaskBlockPool implementations
+// ------------------------------
+void* FTaskBlockPool::Allocate(std::size_t Size)
+{
+    std::size_t SizeClass = GetSizeClass(Size);
+    if (SizeClass >= kSizeClassCount || kbCacheDestroyed)
+    {
+        return ::operator new(Size);
+    }
+
+    auto& Blocks = kBlockCache.FreeBlocks[SizeClass];
+    if (Blocks.empty())
+    {
+        if (Blocks.capacity() == 0)
+        {
+            Blocks.reserve(kMaxCachedBlocks);
+        }
+
+        RefillBlocks(SizeClass, Blocks);
+    }
+
+    if (!Blocks.empty())
+    {
+        void* Block = Blocks.back();
+        Blocks.pop_back();
+        return Block;
+    }
+
+    // 总是按分级大小分配，释放后可以给同一分级的任意请求复用
+    return ::operator new((SizeClass + 1) * kBlockGranularity);
+}
+
+void FTaskBlockPool::Deallocate(void* Block, std::size_t Size)
+{
+    std::size_t SizeClass = GetSizeClass(Size);
+    if (SizeClass >= kSizeClassCount || kbCacheDestroyed)
+    {
+        ::operator delete(Block);
+        return;
+    }
+
+    auto& Blocks = kBlockCache.FreeBlocks[SizeClass];
+    if (Blocks.capacity() == 0)
+    {
+        Blocks.reserve(kMaxCachedBlocks);
+    }
+
+    if (Blocks.size() >= kMaxCachedBlocks)
+    {
+        FlushBlocks(SizeClass, Blocks, kTransferBatchSize);
+    }
+
+    Blocks.push_back(Block);
+}
+
+// FTaskQueue implementations
+// --------------------------
+void FTaskQueue::PushBack(FTask&& Task, std::int64_t EnqueueTime)
+{
+    if (_Size == _Capacity)
+    {
+        Grow();
+    }
+
+    auto& Entry       = _Entries[(_Head + _Size) % _Capacity];
+    Entry.Task        = std::move(Task);
+    Entry.EnqueueTime = EnqueueTime;
+    ++_Size;
+}
+
+FTaskQueue::FEntry FTaskQueue::PopBack()
+{
+    --_Size;
+    return std::move(_Entries[(_Head + _Size) % _Capacity]);
+}
+
+FTaskQueue::FEntry FTaskQueue::PopFront()
+{
+    FEntry Entry = std::move(_Entries[_Head]);
+    _Head = (_Head + 1) % _Capacity;
+    --_Size;
+    return Entry;
+}
+
+void FTaskQueue::Grow()
+{
+    std::size_t NewCapacity = _Capacity == 0 ? 64 : _Capacity * 2;
+    auto NewEntries = std::make_unique<FEntry[]>(NewCapacity);
+    for (std::size_t i = 0; i != _Size; ++i)
+    {
+        NewEntries[i] = std::move(_Entries[(_Head + i) % _Capacity]);
+    }
+
+    _Entries  = std::move(NewEntries);
+    _Capacity = NewCapacity;
+    _Head     = 0;
+}
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
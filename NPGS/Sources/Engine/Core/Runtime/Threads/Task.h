@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+// 线程池任务使用的小块内存池。按 64 字节分级，每个线程缓存自己释放的块，缓存为空或溢出时与共享的中心缓存成批交换，
+// 块在哪个线程释放都能回到分配它的线程，稳定运行后分配和释放都不会访问堆。超过最大分级的请求直接使用 operator new
+class FTaskBlockPool
+{
+public:
+    static void* Allocate(std::size_t Size);
+    static void Deallocate(void* Block, std::size_t Size);
+
+public:
+    static constexpr std::size_t kBlockGranularity  = 64;
+    static constexpr std::size_t kSizeClassCount    = 4;
+    static constexpr std::size_t kMaxCachedBlocks   = 1024; // 每个线程每个分级最多缓存的块数，超出时把一批块交给中心缓存
+    static constexpr std::size_t kTransferBatchSize = 512;  // 线程缓存与中心缓存之间一次交换的块数
+};
+
+// 从 FTaskBlockPool 分配的分配器，用于 std::promise 的共享状态，使 Submit 返回的 future 不再单独分配堆内存
+template <typename Type>
+class TTaskStateAllocator
+{
+public:
+    using value_type = Type;
+
+public:
+    TTaskStateAllocator() = default;
+
+    template <typename OtherType>
+    TTaskStateAllocator(const TTaskStateAllocator<OtherType>&) noexcept
+    {
+    }
+
+    Type* allocate(std::size_t Count);
+    void deallocate(Type* Pointer, std::size_t Count) noexcept;
+
+    template <typename OtherType>
+    bool operator==(const TTaskStateAllocator<OtherType>&) const noexcept;
+};
+
+// 只能移动的 void() 可调用对象。不超过 kInlineSize 的可调用对象直接存放在对象内部，
+// 代替 std::function，后者不能保存只能移动的 std::promise，并且在各个标准库中的内联容量都很小
+class FTask
+{
+public:
+    static constexpr std::size_t kInlineSize = 64;
+
+public:
+    FTask() = default;
+
+    template <typename Func>
+    requires (!std::is_same_v<std::decay_t<Func>, FTask>)
+    FTask(Func&& Pred);
+
+    FTask(const FTask&) = delete;
+    FTask(FTask&& Other) noexcept;
+    ~FTask();
+
+    FTask& operator=(const FTask&) = delete;
+    FTask& operator=(FTask&& Other) noexcept;
+
+    void operator()();
+    explicit operator bool() const;
+
+    void Reset();
+
+private:
+    struct FOperations
+    {
+        void (*Invoke)(void* Storage);
+        void (*Move)(void* Source, void* Target) noexcept; // 移动到 Target 并销毁 Source
+        void (*Destroy)(void* Storage) noexcept;
+    };
+
+    template <typename Func>
+    static constexpr bool kbStoredInline = sizeof(Func) <= kInlineSize &&
+                                           alignof(Func) <= alignof(std::max_align_t) &&
+                                           std::is_nothrow_move_constructible_v<Func>;
+
+    template <typename Func>
+    static const FOperations* GetOperations();
+
+private:
+    alignas(std::max_align_t) std::byte _Storage[kInlineSize];
+    const FOperations*                  _Operations{ nullptr };
+};
+
+// 任务环形队列，支持两端弹出。容量只增不减，稳定运行后入队出队不会分配内存
+// 不是线程安全的，由调用方加锁
+class FTaskQueue
+{
+public:
+    struct FEntry
+    {
+        FTask        Task;
+        std::int64_t EnqueueTime{}; // 入队时刻，单位纳秒，未记录时为 0
+    };
+
+public:
+    FTaskQueue() = default;
+    FTaskQueue(const FTaskQueue&) = delete;
+    FTaskQueue(FTaskQueue&&)      = delete;
+    ~FTaskQueue() = default;
+
+    FTaskQueue& operator=(const FTaskQueue&) = delete;
+    FTaskQueue& operator=(FTaskQueue&&)      = delete;
+
+    void PushBack(FTask&& Task, std::int64_t EnqueueTime = 0);
+    FEntry PopBack();
+    FEntry PopFront();
+    bool Empty() const;
+    std::size_t Size() const;
+
+private:
+    void Grow();
+
+private:
+    std::unique_ptr<FEntry[]> _Entries;
+    std::size_t               _Capacity{};
+    std::size_t               _Head{};
+    std::size_t               _Size{};
+};
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
+
+#include "Task.inl"
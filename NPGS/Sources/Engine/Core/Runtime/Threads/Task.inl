@@ -0,0 +1,179 @@
+#include "Task.h"
+
+_NPGS_BEGIN
+_RUNTIME_BEGIN
+_THREAD_BEGIN
+
+template <typename Type>
+inline Type* TTaskStateAllocator<Type>::allocate(std::size_t Count)
+{
+    if constexpr (alignof(Type) > alignof(std::max_align_t))
+    {
+        return static_cast<Type*>(::operator new(Count * sizeof(Type), std::align_val_t{ alignof(Type) }));
+    }
+    else
+    {
+        return static_cast<Type*>(FTaskBlockPool::Allocate(Count * sizeof(Type)));
+    }
+}
+
+template <typename Type>
+inline void TTaskStateAllocator<Type>::deallocate(Type* Pointer, std::size_t Count) noexcept
+{
+    if constexpr (alignof(Type) > alignof(std::max_align_t))
+    {
+        ::operator delete(Pointer, std::align_val_t{ alignof(Type) });
+    }
+    else
+    {
+        FTaskBlockPool::Deallocate(Pointer, Count * sizeof(Type));
+    }
+}
+
+template <typename Type>
+template <typename OtherType>
+inline bool TTaskStateAllocator<Type>::operator==(const TTaskStateAllocator<OtherType>&) const noexcept
+{
+    return true;
+}
+
+template <typename Func>
+requires (!std::is_same_v<std::decay_t<Func>, FTask>)
+inline FTask::FTask(Func&& Pred)
+{
+    using FuncType = std::decay_t<Func>;
+    if constexpr (kbStoredInline<FuncType>)
+    {
+        ::new (static_cast<void*>(_Storage)) FuncType(std::forward<Func>(Pred));
+    }
+    else
+    {
+        // 放不下时在内存池中分配，对象内只保存指针
+        static_assert(alignof(FuncType) <= alignof(std::max_align_t), "Over-aligned task callables are not supported.");
+        void* Block = FTaskBlockPool::Allocate(sizeof(FuncType));
+        try
+        {
+            ::new (Block) FuncType(std::forward<Func>(Pred));
+        }
+        catch (...)
+        {
+            FTaskBlockPool::Deallocate(Block, sizeof(FuncType));
+            throw;
+        }
+
+        ::new (static_cast<void*>(_Storage)) FuncType*(static_cast<FuncType*>(Block));
+    }
+
+    _Operations = GetOperations<FuncType>();
+}
+
+inline FTask::FTask(FTask&& Other) noexcept
+{
+    if (Other._Operations != nullptr)
+    {
+        Other._Operations->Move(Other._Storage, _Storage);
+        _Operations = std::exchange(Other._Operations, nullptr);
+    }
+}
+
+inline FTask::~FTask()
+{
+    Reset();
+}
+
+inline FTask& FTask::operator=(FTask&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Reset();
+        if (Other._Operations != nullptr)
+        {
+            Other._Operations->Move(Other._Storage, _Storage);
+            _Operations = std::exchange(Other._Operations, nullptr);
+        }
+    }
+
+    return *this;
+}
+
+inline void FTask::operator()()
+{
+    _Operations->Invoke(_Storage);
+}
+
+inline FTask::operator bool() const
+{
+    return _Operations != nullptr;
+}
+
+inline void FTask::Reset()
+{
+    if (_Operations != nullptr)
+    {
+        _Operations->Destroy(_Storage);
+        _Operations = nullptr;
+    }
+}
+
+template <typename Func>
+inline const FTask::FOperations* FTask::GetOperations()
+{
+    static constexpr FOperations kOperations
+    {
+        .Invoke = [](void* Storage) -> void
+        {
+            if constexpr (kbStoredInline<Func>)
+            {
+                (*std::launder(static_cast<Func*>(Storage)))();
+            }
+            else
+            {
+                (**std::launder(static_cast<Func**>(Storage)))();
+            }
+        },
+
+        .Move = [](void* Source, void* Target) noexcept -> void
+        {
+            if constexpr (kbStoredInline<Func>)
+            {
+                Func* SourceFunc = std::launder(static_cast<Func*>(Source));
+                ::new (Target) Func(std::move(*SourceFunc));
+                SourceFunc->~Func();
+            }
+            else
+            {
+                ::new (Target) Func*(*std::launder(static_cast<Func**>(Source)));
+            }
+        },
+
+        .Destroy = [](void* Storage) noexcept -> void
+        {
+            if constexpr (kbStoredInline<Func>)
+            {
+                std::launder(static_cast<Func*>(Storage))->~Func();
+            }
+            else
+            {
+                Func* HeapFunc = *std::launder(static_cast<Func**>(Storage));
+                HeapFunc->~Func();
+                FTaskBlockPool::Deallocate(HeapFunc, sizeof(Func));
+            }
+        }
+    };
+
+    return &kOperations;
+}
+
+NPGS_INLINE bool FTaskQueue::Empty() const
+{
+    return _Size == 0;
+}
+
+NPGS_INLINE std::size_t FTaskQueue::Size() const
+{
+    return _Size;
+}
+
+_THREAD_END
+_RUNTIME_END
+_NPGS_END
@@ -2,7 +2,25 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <set>
+#include <thread>
+
+#if defined(_WIN32)
 #include <Windows.h>
+#elif defined(__linux__)
+#include <cctype>
+#include <pthread.h>
+#include <sched.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#endif
 
 _NPGS_BEGIN
 _RUNTIME_BEGIN
@@ -10,64 +28,95 @@ _THREAD_BEGIN
 
 namespace
 {
-    int GetPhysicalCoreCount()
+#if defined(__linux__)
+    // 解析 sysfs 中 "0-3,8,10-11" 格式的 CPU 列表
+    std::vector<int> ReadCpuList(const std::filesystem::path& Filename)
     {
-        DWORD Length = 0;
-        GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &Length);
-        std::vector<std::uint8_t> Buffer(Length);
-        auto* BufferPtr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(Buffer.data());
-        GetLogicalProcessorInformationEx(RelationProcessorCore, BufferPtr, &Length);
-
-        int CoreCount = 0;
-        while (Length > 0)
+        std::vector<int> Cpus;
+        std::ifstream File(Filename);
+        std::string   Item;
+        while (std::getline(File, Item, ','))
         {
-            if (BufferPtr->Relationship == RelationProcessorCore)
+            std::istringstream Stream(Item);
+            int First = 0;
+            if (!(Stream >> First))
+            {
+                continue;
+            }
+
+            int Last = First;
+            if (Stream.peek() == '-')
+            {
+                Stream.ignore();
+                Stream >> Last;
+            }
+
+            for (int Cpu = First; Cpu <= Last; ++Cpu)
             {
-                ++CoreCount;
+                Cpus.push_back(Cpu);
             }
+        }
+
+        return Cpus;
+    }
 
-            Length -= BufferPtr->Size;
-            BufferPtr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(
-                reinterpret_cast<std::uint8_t*>(BufferPtr) + BufferPtr->Size);
+    int ReadSysfsInt(const std::filesystem::path& Filename, int Default)
+    {
+        std::ifstream File(Filename);
+        int Value = Default;
+        if (!(File >> Value))
+        {
+            return Default;
         }
 
-        return CoreCount;
+        return Value;
+    }
+#endif
+
+    int GetCurrentProcessorIndex()
+    {
+#if defined(_WIN32)
+        return static_cast<int>(GetCurrentProcessorNumber());
+#elif defined(__linux__)
+        return sched_getcpu();
+#else
+        return -1;
+#endif
     }
 }
 
 // ThreadPool implementations
 // --------------------------
+namespace
+{
+    // 当前线程在线程池中的下标，不是工作线程时为 -1
+    thread_local int kCurrentWorkerIndex = -1;
+    // 当前线程正在执行的任务所在的通道，工作线程之外为 kGeneration
+    thread_local FThreadPool::ETaskLane kCurrentLane = FThreadPool::ETaskLane::kGeneration;
+}
+
 FThreadPool::FThreadPool()
     :
+    _bRunning(false),
+    _bTelemetryEnabled(false),
+    _PendingTaskCount(0),
+    _SleepingThreadCount(0),
+    _NextWorkerIndex(0),
+    _PhysicalCores(DetectTopology()),
+    _NumaNode(-1),
+    _bPhysicalCoreOnly(true),
     _Terminate(false),
-    _kMaxThreadCount(GetPhysicalCoreCount()),
-    _kPhysicalCoreCount(GetPhysicalCoreCount())
+    _kMaxThreadCount(static_cast<int>(_PhysicalCores.size())),
+    _kPhysicalCoreCount(static_cast<int>(_PhysicalCores.size())),
+    _kHyperThreadIndex(0)
 {
-    for (std::size_t i = 0; i != _kPhysicalCoreCount; ++i)
+    // 所有队列创建完成后再启动线程，窃取时不会访问到未构造的队列。队列在重新启动时保留
+    for (int i = 0; i != _kPhysicalCoreCount; ++i)
     {
-        _Threads.emplace_back([this]() -> void
-        {
-            while (true)
-            {
-                std::function<void()> Task;
-                {
-                    std::unique_lock<std::mutex> Mutex(_Mutex);
-                    _Condition.wait(Mutex, [this]() -> bool { return !_Tasks.empty() || _Terminate; });
-                    if (_Terminate && _Tasks.empty())
-                    {
-                        return;
-                    }
-
-                    Task = std::move(_Tasks.front());
-                    _Tasks.pop();
-                }
-
-                Task();
-            }
-        });
-
-        SetThreadAffinity(_Threads.back(), i);
+        _Workers.push_back(std::make_unique<FWorker>());
     }
+
+    Start();
 }
 
 FThreadPool::~FThreadPool()
@@ -75,8 +124,47 @@ FThreadPool::~FThreadPool()
     Terminate();
 }
 
+void FThreadPool::Start()
+{
+    std::lock_guard<std::shared_mutex> Lock(_LifecycleMutex);
+    StartThreads();
+}
+
 void FThreadPool::Terminate()
 {
+    std::lock_guard<std::shared_mutex> Lock(_LifecycleMutex);
+    StopThreads();
+}
+
+void FThreadPool::StartThreads()
+{
+    if (_bRunning.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Mutex(_Mutex);
+        _Terminate = false;
+    }
+
+    int ThreadCount = _kMaxThreadCount.load(std::memory_order_relaxed);
+    for (int i = 0; i != ThreadCount; ++i)
+    {
+        _Threads.emplace_back(&FThreadPool::WorkerLoop, this, i);
+    }
+
+    ApplyThreadAffinity();
+    _bRunning.store(true, std::memory_order_release);
+}
+
+void FThreadPool::StopThreads()
+{
+    if (!_bRunning.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
     {
         std::unique_lock<std::mutex> Mutex(_Mutex);
         _Terminate = true;
@@ -89,6 +177,9 @@ void FThreadPool::Terminate()
             Thread.join();
         }
     }
+
+    _Threads.clear();
+    _bRunning.store(false, std::memory_order_release);
 }
 
 FThreadPool* FThreadPool::GetInstance()
@@ -97,12 +188,448 @@ FThreadPool* FThreadPool::GetInstance()
     return &kInstance;
 }
 
-void FThreadPool::SetThreadAffinity(std::thread& Thread, std::size_t CoreId) const
+void FThreadPool::ChangeHyperThread()
+{
+    std::lock_guard<std::shared_mutex> Lock(_LifecycleMutex);
+    _kHyperThreadIndex = 1 - _kHyperThreadIndex;
+    ApplyThreadAffinity();
+}
+
+void FThreadPool::SetThreadPlacement(bool bPhysicalCoreOnly, int NumaNode)
+{
+    std::lock_guard<std::shared_mutex> Lock(_LifecycleMutex);
+    _bPhysicalCoreOnly = bPhysicalCoreOnly;
+    _NumaNode          = NumaNode;
+
+    int ThreadCount = static_cast<int>(GetPlacementCores().size());
+    if (ThreadCount == _kMaxThreadCount.load(std::memory_order_relaxed))
+    {
+        ApplyThreadAffinity();
+        return;
+    }
+
+    // 每个核心一个工作线程，线程数变化时执行完已提交的任务，再按新的线程数重新启动
+    bool bRunning = _bRunning.load(std::memory_order_acquire);
+    StopThreads();
+    _kMaxThreadCount.store(ThreadCount, std::memory_order_relaxed);
+    if (bRunning)
+    {
+        StartThreads();
+    }
+}
+
+int FThreadPool::GetNumaNodeCount() const
 {
-    HANDLE Handle = Thread.native_handle();
+    std::set<int> NumaNodes;
+    for (const auto& Core : _PhysicalCores)
+    {
+        NumaNodes.insert(Core.NumaNode);
+    }
+
+    return static_cast<int>(NumaNodes.size());
+}
+
+int FThreadPool::GetCurrentNumaNode() const
+{
+    int Processor = GetCurrentProcessorIndex();
+    for (const auto& Core : _PhysicalCores)
+    {
+        if (std::ranges::find(Core.LogicalProcessors, Processor) != Core.LogicalProcessors.end())
+        {
+            return Core.NumaNode;
+        }
+    }
+
+    return 0;
+}
+
+std::vector<FThreadPool::FPhysicalCore> FThreadPool::DetectTopology()
+{
+    std::vector<FPhysicalCore> PhysicalCores;
+
+#if defined(_WIN32)
+    // 只处理第 0 个处理器组，与原先的绑定方式一致
+    DWORD Length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &Length);
+    std::vector<std::uint8_t> Buffer(Length);
+    auto* BufferPtr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(Buffer.data());
+    if (!GetLogicalProcessorInformationEx(RelationAll, BufferPtr, &Length))
+    {
+        Length = 0;
+    }
+
+    std::vector<std::pair<int, KAFFINITY>> NumaNodes;
+    while (Length > 0)
+    {
+        if (BufferPtr->Relationship == RelationProcessorCore && BufferPtr->Processor.GroupMask[0].Group == 0)
+        {
+            FPhysicalCore Core;
+            KAFFINITY Mask = BufferPtr->Processor.GroupMask[0].Mask;
+            for (int i = 0; i != static_cast<int>(sizeof(KAFFINITY) * 8); ++i)
+            {
+                if (Mask & (static_cast<KAFFINITY>(1) << i))
+                {
+                    Core.LogicalProcessors.push_back(i);
+                }
+            }
+
+            if (!Core.LogicalProcessors.empty())
+            {
+                PhysicalCores.push_back(std::move(Core));
+            }
+        }
+        else if (BufferPtr->Relationship == RelationNumaNode && BufferPtr->NumaNode.GroupMask.Group == 0)
+        {
+            NumaNodes.emplace_back(static_cast<int>(BufferPtr->NumaNode.NodeNumber), BufferPtr->NumaNode.GroupMask.Mask);
+        }
+
+        Length -= BufferPtr->Size;
+        BufferPtr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(
+            reinterpret_cast<std::uint8_t*>(BufferPtr) + BufferPtr->Size);
+    }
+
+    for (auto& Core : PhysicalCores)
+    {
+        for (const auto& [NodeNumber, Mask] : NumaNodes)
+        {
+            if (Mask & (static_cast<KAFFINITY>(1) << Core.LogicalProcessors.front()))
+            {
+                Core.NumaNode = NodeNumber;
+                break;
+            }
+        }
+    }
+#elif defined(__linux__)
+    // 按 (NUMA 节点, 封装, 核心编号) 把在线的逻辑处理器归并为物理核心
+    const std::filesystem::path kCpuDirectory("/sys/devices/system/cpu");
+    const std::filesystem::path kNodeDirectory("/sys/devices/system/node");
+
+    std::map<int, int> NumaNodeOfCpu;
+    std::error_code ErrorCode;
+    for (const auto& Entry : std::filesystem::directory_iterator(kNodeDirectory, ErrorCode))
+    {
+        std::string Name = Entry.path().filename().string();
+        if (!Name.starts_with("node") || Name.size() == 4 || !std::isdigit(static_cast<unsigned char>(Name[4])))
+        {
+            continue;
+        }
+
+        int NodeNumber = std::atoi(Name.c_str() + 4);
+        for (int Cpu : ReadCpuList(Entry.path() / "cpulist"))
+        {
+            NumaNodeOfCpu[Cpu] = NodeNumber;
+        }
+    }
+
+    // 只使用进程允许运行的逻辑处理器，taskset 和 cgroup 的限制都体现在亲和性掩码中
+    std::vector<int> AllowedCpus;
+    cpu_set_t AllowedCpuSet;
+    CPU_ZERO(&AllowedCpuSet);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &AllowedCpuSet) == 0)
+    {
+        for (int Cpu = 0; Cpu != CPU_SETSIZE; ++Cpu)
+        {
+            if (CPU_ISSET(Cpu, &AllowedCpuSet))
+            {
+                AllowedCpus.push_back(Cpu);
+            }
+        }
+    }
+    else
+    {
+        AllowedCpus = ReadCpuList(kCpuDirectory / "online");
+    }
+
+    std::map<std::tuple<int, int, int>, FPhysicalCore> Cores;
+    for (int Cpu : AllowedCpus)
+    {
+        auto Topology  = kCpuDirectory / ("cpu" + std::to_string(Cpu)) / "topology";
+        int  PackageId = ReadSysfsInt(Topology / "physical_package_id", 0);
+        int  CoreId    = ReadSysfsInt(Topology / "core_id", Cpu);
+        int  NumaNode  = NumaNodeOfCpu.contains(Cpu) ? NumaNodeOfCpu[Cpu] : 0;
+
+        auto& Core = Cores[{ NumaNode, PackageId, CoreId }];
+        Core.NumaNode = NumaNode;
+        Core.LogicalProcessors.push_back(Cpu);
+    }
+
+    for (auto& [Key, Core] : Cores)
+    {
+        PhysicalCores.push_back(std::move(Core));
+    }
+#endif
+
+    // 无法读取拓扑时把每个逻辑处理器当作一个物理核心
+    if (PhysicalCores.empty())
+    {
+        int ProcessorCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+        for (int i = 0; i != ProcessorCount; ++i)
+        {
+            PhysicalCores.push_back({ { i }, 0 });
+        }
+    }
+
+    std::ranges::stable_sort(PhysicalCores, [](const FPhysicalCore& Core1, const FPhysicalCore& Core2) -> bool
+    {
+        return Core1.NumaNode < Core2.NumaNode;
+    });
+
+    return PhysicalCores;
+}
+
+std::vector<const FThreadPool::FPhysicalCore*> FThreadPool::GetPlacementCores() const
+{
+    std::vector<const FPhysicalCore*> Cores;
+    for (const auto& Core : _PhysicalCores)
+    {
+        if (_NumaNode == -1 || Core.NumaNode == _NumaNode)
+        {
+            Cores.push_back(&Core);
+        }
+    }
+
+    if (Cores.empty())
+    {
+        for (const auto& Core : _PhysicalCores)
+        {
+            Cores.push_back(&Core);
+        }
+    }
+
+    return Cores;
+}
+
+void FThreadPool::ApplyThreadAffinity()
+{
+    // 线程数与放置的核心数相同，每个线程独占一个核心
+    auto Cores = GetPlacementCores();
+    for (std::size_t i = 0; i != _Threads.size(); ++i)
+    {
+        const auto& Processors = Cores[i % Cores.size()]->LogicalProcessors;
+        if (_bPhysicalCoreOnly)
+        {
+            std::size_t SmtIndex = std::min(static_cast<std::size_t>(_kHyperThreadIndex), Processors.size() - 1);
+            SetThreadAffinity(_Threads[i], { Processors[SmtIndex] });
+        }
+        else
+        {
+            SetThreadAffinity(_Threads[i], Processors);
+        }
+    }
+}
+
+void FThreadPool::SetThreadAffinity(std::thread& Thread, const std::vector<int>& LogicalProcessors) const
+{
+#if defined(_WIN32)
     DWORD_PTR Mask = 0;
-    Mask = static_cast<DWORD_PTR>(Bit(CoreId * 2) + _kHyperThreadIndex);
-    SetThreadAffinityMask(Handle, Mask);
+    for (int Processor : LogicalProcessors)
+    {
+        Mask |= static_cast<DWORD_PTR>(1) << Processor;
+    }
+
+    SetThreadAffinityMask(Thread.native_handle(), Mask);
+#elif defined(__linux__)
+    cpu_set_t CpuSet;
+    CPU_ZERO(&CpuSet);
+    for (int Processor : LogicalProcessors)
+    {
+        CPU_SET(Processor, &CpuSet);
+    }
+
+    pthread_setaffinity_np(Thread.native_handle(), sizeof(cpu_set_t), &CpuSet);
+#endif
+}
+
+std::vector<FThreadPool::FWorkerTelemetry> FThreadPool::GetTelemetry() const
+{
+    std::vector<FWorkerTelemetry> Telemetry(_Workers.size());
+    for (std::size_t i = 0; i != _Workers.size(); ++i)
+    {
+        const auto& Counters = _Workers[i]->Counters;
+        auto&       Result   = Telemetry[i];
+
+        Result.TaskCount       = Counters.TaskCount.load(std::memory_order_relaxed);
+        Result.StealCount      = Counters.StealCount.load(std::memory_order_relaxed);
+        Result.BusyNanoseconds = Counters.BusyNanoseconds.load(std::memory_order_relaxed);
+        Result.IdleNanoseconds = Counters.IdleNanoseconds.load(std::memory_order_relaxed);
+        for (std::size_t Bucket = 0; Bucket != kHistogramBucketCount; ++Bucket)
+        {
+            Result.QueueWaitHistogram[Bucket] = Counters.QueueWaitHistogram[Bucket].load(std::memory_order_relaxed);
+            Result.RunTimeHistogram[Bucket]   = Counters.RunTimeHistogram[Bucket].load(std::memory_order_relaxed);
+        }
+    }
+
+    return Telemetry;
+}
+
+void FThreadPool::ResetTelemetry()
+{
+    for (auto& Worker : _Workers)
+    {
+        auto& Counters = Worker->Counters;
+        Counters.TaskCount.store(0, std::memory_order_relaxed);
+        Counters.StealCount.store(0, std::memory_order_relaxed);
+        Counters.BusyNanoseconds.store(0, std::memory_order_relaxed);
+        Counters.IdleNanoseconds.store(0, std::memory_order_relaxed);
+        for (std::size_t Bucket = 0; Bucket != kHistogramBucketCount; ++Bucket)
+        {
+            Counters.QueueWaitHistogram[Bucket].store(0, std::memory_order_relaxed);
+            Counters.RunTimeHistogram[Bucket].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+FThreadPool::ETaskLane FThreadPool::GetCurrentLane()
+{
+    return kCurrentLane;
+}
+
+void FThreadPool::PushTask(ETaskLane Lane, FTask&& Task)
+{
+    // 外部线程提交时持有共享锁，Terminate 开始后的提交等到结束完成，再重新启动线程池，任务不会留在无人执行的队列中
+    // 工作线程提交时不加锁：提交的线程自己还在运行，它结束前会执行完所有待执行的任务，加锁反而会与 Terminate 的等待死锁
+    std::shared_lock<std::shared_mutex> Lock(_LifecycleMutex, std::defer_lock);
+    if (kCurrentWorkerIndex < 0)
+    {
+        Lock.lock();
+        while (!_bRunning.load(std::memory_order_acquire))
+        {
+            Lock.unlock();
+            Start();
+            Lock.lock();
+        }
+    }
+
+    // 工作线程提交的任务放进自己的队列，保持局部性；外部线程提交的任务轮流分配
+    std::size_t WorkerIndex = kCurrentWorkerIndex >= 0
+                            ? static_cast<std::size_t>(kCurrentWorkerIndex)
+                            : _NextWorkerIndex.fetch_add(1, std::memory_order_relaxed) % _kMaxThreadCount.load(std::memory_order_relaxed);
+
+    std::int64_t EnqueueTime = _bTelemetryEnabled.load(std::memory_order_relaxed) ? GetTimestamp() : 0;
+
+    auto& Worker = *_Workers[WorkerIndex];
+    {
+        std::lock_guard<std::mutex> Lock(Worker.Mutex);
+        Worker.Lanes[static_cast<std::size_t>(Lane)].PushBack(std::move(Task), EnqueueTime);
+    }
+
+    // 与 WorkerLoop 中先登记休眠再检查任务数的顺序配对，两边都是顺序一致的原子操作，
+    // 要么工作线程看到新任务不休眠，要么这里看到有线程休眠并唤醒它，不会丢失唤醒
+    _PendingTaskCount.fetch_add(1);
+    if (_SleepingThreadCount.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> Lock(_Mutex);
+        }
+        _Condition.notify_one();
+    }
+}
+
+bool FThreadPool::PopTask(int WorkerIndex, FTaskQueue::FEntry& Entry, ETaskLane& Lane)
+{
+    // 按通道优先级查找：先从自己队列的尾部取最近提交的任务，再依次从其他线程队列的头部窃取最早提交的任务
+    std::size_t WorkerCount = _Workers.size();
+    for (std::size_t LaneIndex = 0; LaneIndex != _kLaneCount; ++LaneIndex)
+    {
+        {
+            auto& Worker = *_Workers[WorkerIndex];
+            auto& Tasks  = Worker.Lanes[LaneIndex];
+            std::lock_guard<std::mutex> Lock(Worker.Mutex);
+            if (!Tasks.Empty())
+            {
+                Entry = Tasks.PopBack();
+                Lane  = static_cast<ETaskLane>(LaneIndex);
+                return true;
+            }
+        }
+
+        for (std::size_t Offset = 1; Offset != WorkerCount; ++Offset)
+        {
+            auto& Victim = *_Workers[(WorkerIndex + Offset) % WorkerCount];
+            auto& Tasks  = Victim.Lanes[LaneIndex];
+            std::unique_lock<std::mutex> Lock(Victim.Mutex, std::try_to_lock);
+            if (Lock.owns_lock() && !Tasks.Empty())
+            {
+                Entry = Tasks.PopFront();
+                Lane  = static_cast<ETaskLane>(LaneIndex);
+                if (_bTelemetryEnabled.load(std::memory_order_relaxed))
+                {
+                    _Workers[WorkerIndex]->Counters.StealCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void FThreadPool::WorkerLoop(int WorkerIndex)
+{
+    kCurrentWorkerIndex = WorkerIndex;
+    auto& Counters = _Workers[WorkerIndex]->Counters;
+
+    while (true)
+    {
+        FTaskQueue::FEntry Entry;
+        ETaskLane Lane = ETaskLane::kGeneration;
+        if (PopTask(WorkerIndex, Entry, Lane))
+        {
+            _PendingTaskCount.fetch_sub(1);
+
+            bool bTelemetryEnabled = _bTelemetryEnabled.load(std::memory_order_relaxed);
+            std::int64_t BeginTime = bTelemetryEnabled ? GetTimestamp() : 0;
+
+            kCurrentLane = Lane;
+            Entry.Task();
+            kCurrentLane = ETaskLane::kGeneration;
+
+            if (bTelemetryEnabled)
+            {
+                std::int64_t RunTime = GetTimestamp() - BeginTime;
+                Counters.TaskCount.fetch_add(1, std::memory_order_relaxed);
+                Counters.BusyNanoseconds.fetch_add(RunTime, std::memory_order_relaxed);
+                Counters.RunTimeHistogram[GetHistogramBucket(RunTime)].fetch_add(1, std::memory_order_relaxed);
+                // 统计开启之前入队的任务没有入队时刻
+                if (Entry.EnqueueTime != 0)
+                {
+                    std::size_t Bucket = GetHistogramBucket(BeginTime - Entry.EnqueueTime);
+                    Counters.QueueWaitHistogram[Bucket].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            continue;
+        }
+
+        std::int64_t SleepTime = _bTelemetryEnabled.load(std::memory_order_relaxed) ? GetTimestamp() : 0;
+
+        std::unique_lock<std::mutex> Lock(_Mutex);
+        _SleepingThreadCount.fetch_add(1);
+        _Condition.wait(Lock, [this]() -> bool { return _PendingTaskCount.load() > 0 || _Terminate; });
+        _SleepingThreadCount.fetch_sub(1);
+
+        if (SleepTime != 0)
+        {
+            Counters.IdleNanoseconds.fetch_add(GetTimestamp() - SleepTime, std::memory_order_relaxed);
+        }
+
+        if (_Terminate && _PendingTaskCount.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+std::int64_t FThreadPool::GetTimestamp()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::size_t FThreadPool::GetHistogramBucket(std::int64_t Nanoseconds)
+{
+    std::uint64_t Microseconds = static_cast<std::uint64_t>(std::max(Nanoseconds, static_cast<std::int64_t>(0))) / 1000;
+    return std::min(static_cast<std::size_t>(std::bit_width(Microseconds)), kHistogramBucketCount - 1);
 }
 
 _THREAD_END
@@ -1,32 +1,118 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <exception>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <shared_mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "Engine/Core/Base/Base.h"
+#include "Task.h"
 
 _NPGS_BEGIN
 _RUNTIME_BEGIN
 _THREAD_BEGIN
 
+// 每个工作线程有自己的双端队列，自己从尾部取任务，空闲时从其他线程的头部窃取
+// 工作线程内提交的任务进入自己的队列，外部提交的任务轮流分配给各个工作线程
+// 线程池可以 Terminate 后重新 Start，Terminate 之后提交任务会自动重新启动
 class FThreadPool
 {
 public:
+    // 优先级通道，工作线程总是先取高优先级通道的任务，包括从其他线程窃取
+    enum class ETaskLane : std::uint8_t
+    {
+        kInteractive, // 交互和渲染相关的短任务
+        kIO,          // 资源加载等 I/O 任务
+        kGeneration,  // 恒星系统生成等长时间的后台批量任务
+        kCount
+    };
+
+    static constexpr std::size_t kHistogramBucketCount = 32;
+
+    // 单个工作线程的统计快照。直方图第 0 桶为不足 1 微秒，第 i 桶为 [2^(i-1), 2^i) 微秒，最后一桶包含更长的时间
+    struct FWorkerTelemetry
+    {
+        std::uint64_t TaskCount{};
+        std::uint64_t StealCount{};      // 从其他线程队列中窃取的任务数
+        std::uint64_t BusyNanoseconds{}; // 执行任务的总时间
+        std::uint64_t IdleNanoseconds{}; // 没有任务而休眠的总时间
+        std::array<std::uint64_t, kHistogramBucketCount> QueueWaitHistogram{};
+        std::array<std::uint64_t, kHistogramBucketCount> RunTimeHistogram{};
+    };
+
+private:
+    static constexpr std::size_t _kLaneCount = static_cast<std::size_t>(ETaskLane::kCount);
+
+    // 只由所属的工作线程写入，其他线程随时可以读取或清零
+    struct alignas(64) FWorkerCounters
+    {
+        std::atomic<std::uint64_t> TaskCount{};
+        std::atomic<std::uint64_t> StealCount{};
+        std::atomic<std::uint64_t> BusyNanoseconds{};
+        std::atomic<std::uint64_t> IdleNanoseconds{};
+        std::array<std::atomic<std::uint64_t>, kHistogramBucketCount> QueueWaitHistogram{};
+        std::array<std::atomic<std::uint64_t>, kHistogramBucketCount> RunTimeHistogram{};
+    };
+
+    struct FWorker
+    {
+        std::array<FTaskQueue, _kLaneCount> Lanes;
+        std::mutex                          Mutex;
+        FWorkerCounters                     Counters;
+    };
+
+    // 一个物理核心及其全部逻辑处理器（SMT 兄弟），按 NUMA 节点排列
+    struct FPhysicalCore
+    {
+        std::vector<int> LogicalProcessors;
+        int              NumaNode{};
+    };
+
+public:
+    // 工作线程内提交时沿用当前任务的通道，其他线程提交时使用 kGeneration
     template <typename Func, typename... Args>
     auto Submit(Func&& Pred, Args&&... Params);
 
+    template <typename Func, typename... Args>
+    auto SubmitToLane(ETaskLane Lane, Func&& Pred, Args&&... Params);
+
+    // 不需要返回值的任务，不创建 future，稳定运行后提交时不分配内存。任务抛出的异常会终止程序
+    template <typename Func>
+    void Dispatch(Func&& Pred);
+
+    template <typename Func>
+    void DispatchToLane(ETaskLane Lane, Func&& Pred);
+
+    void Start();
+    // 执行完已提交的全部任务后结束所有工作线程，不能在工作线程中调用
     void Terminate();
+    bool IsRunning() const;
     void ChangeHyperThread();
+    // bPhysicalCoreOnly 为 true 时每个线程只绑定到物理核心的一个逻辑处理器，否则可以在该核心的所有 SMT 兄弟上运行
+    // NumaNode 不为 -1 时工作线程减少为该节点的物理核心数，每个线程绑定到节点的一个核心上
+    // 线程数变化时先执行完已提交的任务再重新启动工作线程，不能在工作线程中调用
+    void SetThreadPlacement(bool bPhysicalCoreOnly, int NumaNode = -1);
     int GetMaxThreadCount() const;
+    int GetPhysicalCoreCount() const;
+    int GetNumaNodeCount() const;
+    int GetCurrentNumaNode() const;
+
+    // 工作线程统计默认关闭，关闭时除一次原子读取外没有额外开销。开启后才会记录任务的入队时刻
+    void SetTelemetryEnabled(bool bEnabled);
+    bool IsTelemetryEnabled() const;
+    std::vector<FWorkerTelemetry> GetTelemetry() const;
+    void ResetTelemetry();
 
     static FThreadPool* GetInstance();
 
@@ -39,24 +125,40 @@ private:
     FThreadPool& operator=(const FThreadPool&) = delete;
     FThreadPool& operator=(FThreadPool&&)      = delete;
 
-    void SetThreadAffinity(std::thread& Thread, std::size_t CoreId) const;
+    static std::vector<FPhysicalCore> DetectTopology();
+    // 以下函数由调用方持有 _LifecycleMutex
+    void StartThreads();
+    void StopThreads();
+    std::vector<const FPhysicalCore*> GetPlacementCores() const;
+    void ApplyThreadAffinity();
+    void SetThreadAffinity(std::thread& Thread, const std::vector<int>& LogicalProcessors) const;
+    static ETaskLane GetCurrentLane();
+    void PushTask(ETaskLane Lane, FTask&& Task);
+    bool PopTask(int WorkerIndex, FTaskQueue::FEntry& Entry, ETaskLane& Lane);
+    static std::int64_t GetTimestamp();
+    static std::size_t GetHistogramBucket(std::int64_t Nanoseconds);
+    void WorkerLoop(int WorkerIndex);
 
 private:
-    std::vector<std::thread>          _Threads;
-    std::queue<std::function<void()>> _Tasks;
-    std::mutex                        _Mutex;
-    std::condition_variable           _Condition;
-    bool                              _Terminate;
-    int                               _kMaxThreadCount;
-    int                               _kPhysicalCoreCount;
-    int                               _kHyperThreadIndex;
+    std::vector<std::thread>                _Threads;
+    std::vector<std::unique_ptr<FWorker>>   _Workers;
+    std::mutex                              _Mutex;          // 只用于工作线程休眠和唤醒
+    std::shared_mutex                       _LifecycleMutex; // 保护线程的启动和结束，外部线程提交任务时持有共享锁
+    std::atomic<bool>                       _bRunning;
+    std::atomic<bool>                       _bTelemetryEnabled;
+    std::condition_variable                 _Condition;
+    std::atomic<std::size_t>                _PendingTaskCount;
+    std::atomic<int>                        _SleepingThreadCount;
+    std::atomic<std::size_t>                _NextWorkerIndex;
+    std::vector<FPhysicalCore>              _PhysicalCores;
+    int                                     _NumaNode;
+    bool                                    _bPhysicalCoreOnly;
+    bool                                    _Terminate;
+    std::atomic<int>                        _kMaxThreadCount; // 工作线程数，等于放置的物理核心数
+    int                                     _kPhysicalCoreCount;
+    int                                     _kHyperThreadIndex;
 };
 
-template <typename DataType, typename ResultType>
-void MakeChunks(int MaxThread, std::vector<DataType>& Data, std::vector<std::vector<DataType>>& DataLists,
-                std::vector<std::promise<std::vector<ResultType>>>& Promises,
-                std::vector<std::future<std::vector<ResultType>>>& ChunkFutures);
-
 _THREAD_END
 _RUNTIME_END
 _NPGS_END
@@ -7,45 +7,76 @@ _THREAD_BEGIN
 template <typename Func, typename... Args>
 inline auto FThreadPool::Submit(Func&& Pred, Args&&... Params)
 {
-    using ReturnType = std::invoke_result_t<Func, Args...>;
-    auto Task = std::make_shared<std::packaged_task<ReturnType()>>(
-        std::bind(std::forward<Func>(Pred), std::forward<Args>(Params)...));
-    std::future<ReturnType> Future = Task->get_future();
+    return SubmitToLane(GetCurrentLane(), std::forward<Func>(Pred), std::forward<Args>(Params)...);
+}
+
+template <typename Func, typename... Args>
+inline auto FThreadPool::SubmitToLane(ETaskLane Lane, Func&& Pred, Args&&... Params)
+{
+    using ReturnType = std::invoke_result_t<std::decay_t<Func>, std::decay_t<Args>...>;
+
+    // promise 的共享状态从任务内存池分配，可调用对象和 promise 一起存放在 FTask 内部
+    std::promise<ReturnType> Promise(std::allocator_arg, TTaskStateAllocator<ReturnType>());
+    std::future<ReturnType>  Future = Promise.get_future();
+    PushTask(Lane, [Promise = std::move(Promise), Pred = std::forward<Func>(Pred),
+                    ...Params = std::forward<Args>(Params)]() mutable -> void
     {
-        std::unique_lock<std::mutex> Mutex(_Mutex);
-        _Tasks.emplace([Task]() -> void { (*Task)(); });
-    }
-    _Condition.notify_one();
+        try
+        {
+            if constexpr (std::is_void_v<ReturnType>)
+            {
+                std::invoke(std::move(Pred), std::move(Params)...);
+                Promise.set_value();
+            }
+            else
+            {
+                Promise.set_value(std::invoke(std::move(Pred), std::move(Params)...));
+            }
+        }
+        catch (...)
+        {
+            Promise.set_exception(std::current_exception());
+        }
+    });
+
     return Future;
 }
 
-NPGS_INLINE void FThreadPool::ChangeHyperThread()
+template <typename Func>
+inline void FThreadPool::Dispatch(Func&& Pred)
 {
-    _kHyperThreadIndex = 1 - _kHyperThreadIndex;
+    DispatchToLane(GetCurrentLane(), std::forward<Func>(Pred));
 }
 
-NPGS_INLINE int FThreadPool::GetMaxThreadCount() const
+template <typename Func>
+inline void FThreadPool::DispatchToLane(ETaskLane Lane, Func&& Pred)
 {
-    return _kMaxThreadCount;
+    PushTask(Lane, FTask(std::forward<Func>(Pred)));
 }
 
-template <typename DataType, typename ResultType>
-inline void MakeChunks(int MaxThread, std::vector<DataType>& Data, std::vector<std::vector<DataType>>& DataLists,
-                       std::vector<std::promise<std::vector<ResultType>>>& Promises,
-                       std::vector<std::future<std::vector<ResultType>>>& ChunkFutures)
+NPGS_INLINE bool FThreadPool::IsRunning() const
 {
-    for (std::size_t i = 0; i != Data.size(); ++i)
-    {
-        std::size_t ThreadId = i % MaxThread;
-        DataLists[ThreadId].push_back(std::move(Data[i]));
-    }
+    return _bRunning.load(std::memory_order_acquire);
+}
+
+NPGS_INLINE void FThreadPool::SetTelemetryEnabled(bool bEnabled)
+{
+    _bTelemetryEnabled.store(bEnabled, std::memory_order_relaxed);
+}
 
-    Promises.resize(MaxThread);
+NPGS_INLINE bool FThreadPool::IsTelemetryEnabled() const
+{
+    return _bTelemetryEnabled.load(std::memory_order_relaxed);
+}
 
-    for (int i = 0; i != MaxThread; ++i)
-    {
-        ChunkFutures.push_back(Promises[i].get_future());
-    }
+NPGS_INLINE int FThreadPool::GetMaxThreadCount() const
+{
+    return _kMaxThreadCount.load(std::memory_order_relaxed);
+}
+
+NPGS_INLINE int FThreadPool::GetPhysicalCoreCount() const
+{
+    return _kPhysicalCoreCount;
 }
 
 _THREAD_END
@@ -7,7 +7,7 @@
 #include "Engine/Core/Math/NumericConstants.h"
 #include "Engine/Core/Types/Properties/Intelli/Civilization.h"
 
-#define DEBUG_OUTPUT
+// #define DEBUG_OUTPUT
 
 _NPGS_BEGIN
 _SYSTEM_BEGIN
@@ -83,6 +83,17 @@ FCivilizationGenerator& FCivilizationGenerator::operator=(FCivilizationGenerator
     return *this;
 }
 
+FCivilizationGenerator& FCivilizationGenerator::Reseed(const std::seed_seq& SeedSequence)
+{
+    _RandomEngine.seed(SeedSequence);
+    _CommonGenerator.Reset();
+    _AsiFiltedProbability.Reset();
+    _DestroyedByDisasterProbability.Reset();
+    _LifeOccurrenceProbability.Reset();
+
+    return *this;
+}
+
 void FCivilizationGenerator::GenerateCivilization(const Astro::AStar* Star, float PoyntingVector, Astro::APlanet* Planet)
 {
     if (Star->GetAge() < 2.4e9 || !_LifeOccurrenceProbability(_RandomEngine))
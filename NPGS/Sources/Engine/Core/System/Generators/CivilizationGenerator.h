@@ -38,6 +38,7 @@ public:
     FCivilizationGenerator& operator=(const FCivilizationGenerator& Other);
     FCivilizationGenerator& operator=(FCivilizationGenerator&& Other) noexcept;
 
+    FCivilizationGenerator& Reseed(const std::seed_seq& SeedSequence);
     void GenerateCivilization(const Astro::AStar* Star, float PoyntingVector, Astro::APlanet* Planet);
 
 private:
@@ -18,7 +18,7 @@
 #include "Engine/Core/Types/Properties/StellarClass.h"
 #include "Engine/Utils/Utils.h"
 
-#define DEBUG_OUTPUT
+// #define DEBUG_OUTPUT
 
 _NPGS_BEGIN
 _SYSTEM_BEGIN
@@ -222,6 +222,29 @@ FOrbitalGenerator& FOrbitalGenerator::operator=(FOrbitalGenerator&& Other) noexc
     return *this;
 }
 
+FOrbitalGenerator& FOrbitalGenerator::Reseed(const std::seed_seq& SeedSequence)
+{
+    // 与构造函数的播种过程保持一致，保证重新播种后的随机序列和新构造的生成器相同
+    _RandomEngine.seed(SeedSequence);
+    _RingsProbabilities[0].Reset();
+    _RingsProbabilities[1].Reset();
+    _BinaryPeriodDistribution.Reset();
+    _CommonGenerator.Reset();
+    _AsteroidBeltProbability.Reset();
+    _MigrationProbability.Reset();
+    _ScatteringProbability.Reset();
+    _WalkInProbability.Reset();
+
+    std::vector<std::uint32_t> Seeds(SeedSequence.size());
+    SeedSequence.param(Seeds.begin());
+    std::shuffle(Seeds.begin(), Seeds.end(), _RandomEngine);
+    std::seed_seq ShuffledSeeds(Seeds.begin(), Seeds.end());
+
+    _CivilizationGenerator->Reseed(ShuffledSeeds);
+
+    return *this;
+}
+
 void FOrbitalGenerator::GenerateOrbitals(Astro::FStellarSystem& System)
 {
     if (System.StarsData().size() == 2)
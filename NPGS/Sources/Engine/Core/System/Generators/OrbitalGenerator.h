@@ -60,6 +60,7 @@ public:
     FOrbitalGenerator& operator=(const FOrbitalGenerator& Other);
     FOrbitalGenerator& operator=(FOrbitalGenerator&& Other) noexcept;
 
+    FOrbitalGenerator& Reseed(const std::seed_seq& SeedSequence);
     void GenerateOrbitals(Astro::FStellarSystem& System);
 
 private:
@@ -581,7 +581,7 @@ Astro::AStar FStellarGenerator::GenerateStar(FBasicProperties& Properties)
                 DeathStar = GenerateStar(Properties);
             }
 
-            return DeathStar;
+            return std::move(DeathStar); // 异常对象通过引用捕获，需要显式移动，避免复制
         }
 
         break;
@@ -694,6 +694,55 @@ Astro::AStar FStellarGenerator::GenerateStar(FBasicProperties& Properties)
     return Star;
 }
 
+FStellarGenerator& FStellarGenerator::Reseed(const std::seed_seq& SeedSequence)
+{
+    // 重新播种并清除各分布缓存的状态，之后的随机序列与用同一种子序列新构造的生成器一致
+    _RandomEngine.seed(SeedSequence);
+
+    for (auto& Generator : _MagneticGenerators)
+    {
+        Generator.Reset();
+    }
+
+    for (auto& Generator : _FeHGenerators)
+    {
+        if (Generator != nullptr)
+        {
+            Generator->Reset();
+        }
+    }
+
+    for (auto& Generator : _SpinGenerators)
+    {
+        Generator.Reset();
+    }
+
+    _AgeGenerator.Reset();
+    _CommonGenerator.Reset();
+
+    if (_LogMassGenerator != nullptr)
+    {
+        _LogMassGenerator->Reset();
+    }
+
+    return *this;
+}
+
+FStellarGenerator& FStellarGenerator::SetLogMassSuggestNormal(float Mean, float Sigma)
+{
+    auto* Normal = dynamic_cast<Util::TNormalDistribution<>*>(_LogMassGenerator.get());
+    if (Normal != nullptr)
+    {
+        Normal->SetParam(Mean, Sigma);
+    }
+    else
+    {
+        _LogMassGenerator = std::make_unique<Util::TNormalDistribution<>>(Mean, Sigma);
+    }
+
+    return *this;
+}
+
 template <typename CsvType>
 requires std::is_class_v<CsvType>
 CsvType* FStellarGenerator::LoadCsvAsset(const std::string& Filename, const std::vector<std::string>& Headers)
@@ -132,7 +132,11 @@ public:
     Astro::AStar GenerateStar();
     Astro::AStar GenerateStar(FBasicProperties& Properties);
 
+    FStellarGenerator& Reseed(const std::seed_seq& SeedSequence);
+
     FStellarGenerator& SetLogMassSuggestDistribution(std::unique_ptr<Util::TDistribution<>>&& Distribution);
+    // 把质量建议分布设为对数正态分布。已经是正态分布时就地修改参数，不分配内存，用于逐颗生成伴星
+    FStellarGenerator& SetLogMassSuggestNormal(float Mean, float Sigma);
     FStellarGenerator& SetUniverseAge(float Age);
     FStellarGenerator& SetAgeLowerLimit(float Limit);
     FStellarGenerator& SetAgeUpperLimit(float Limit);
@@ -1,28 +1,206 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <functional>
-#include <future>
-#include <memory>
+#include <limits>
+#include <span>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NPGS_OCTREE_USE_SSE
+#endif // defined(_M_X64) || defined(__SSE2__)
+
 #include "Engine/Core/Base/Base.h"
+#include "Engine/Core/Runtime/Threads/Parallel.h"
 #include "Engine/Core/Runtime/Threads/ThreadPool.h"
 
 _NPGS_BEGIN
 _SYSTEM_BEGIN
 _SPATIAL_BEGIN
 
+template <typename LinkTargetType>
+class TOctree;
+
+// 包围盒与查询区域的关系
+enum class EContainment : std::uint8_t
+{
+    kOutside,
+    kIntersect,
+    kInside
+};
+
+// 视锥体，由 6 个法线朝内的平面围成，点 P 在平面内侧时 dot(Normal, P) + w >= 0
+struct FFrustum
+{
+    std::array<glm::vec4, 6> Planes{};
+
+    // 从视图投影矩阵中提取平面，近平面取 -w <= z，对深度范围为 [-1, 1] 的矩阵是精确的
+    // 对深度范围为 [0, 1] 的矩阵，近平面外移到一半近距离处，只会多保留一些点，不会剔除可见的点
+    // FCamera 的无限远投影在不同 glm 版本中深度范围不同，两种情况都适用。无限远投影的远平面恒成立，不影响结果
+    static FFrustum FromMatrix(const glm::mat4& Matrix)
+    {
+        auto GetRow = [&Matrix](int Row) -> glm::vec4
+        {
+            return glm::vec4(Matrix[0][Row], Matrix[1][Row], Matrix[2][Row], Matrix[3][Row]);
+        };
+
+        FFrustum Frustum;
+        Frustum.Planes =
+        {
+            GetRow(3) + GetRow(0), GetRow(3) - GetRow(0),
+            GetRow(3) + GetRow(1), GetRow(3) - GetRow(1),
+            GetRow(3) + GetRow(2), GetRow(3) - GetRow(2)
+        };
+
+        return Frustum;
+    }
+
+    bool Contains(const glm::vec3& Point) const
+    {
+        for (const auto& Plane : Planes)
+        {
+            if (glm::dot(glm::vec3(Plane), Point) + Plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // 对每个平面只检查包围盒在法线方向上最靠前和最靠后的两个顶点
+    EContainment Classify(const glm::vec3& MinBound, const glm::vec3& MaxBound) const
+    {
+        EContainment Result = EContainment::kInside;
+        for (const auto& Plane : Planes)
+        {
+            glm::vec3 Normal(Plane);
+            glm::vec3 Front(Normal.x >= 0.0f ? MaxBound.x : MinBound.x,
+                            Normal.y >= 0.0f ? MaxBound.y : MinBound.y,
+                            Normal.z >= 0.0f ? MaxBound.z : MinBound.z);
+            glm::vec3 Back(Normal.x >= 0.0f ? MinBound.x : MaxBound.x,
+                           Normal.y >= 0.0f ? MinBound.y : MaxBound.y,
+                           Normal.z >= 0.0f ? MinBound.z : MaxBound.z);
+
+            if (glm::dot(Normal, Front) + Plane.w < 0.0f)
+            {
+                return EContainment::kOutside;
+            }
+
+            if (glm::dot(Normal, Back) + Plane.w < 0.0f)
+            {
+                Result = EContainment::kIntersect;
+            }
+        }
+
+        return Result;
+    }
+};
+
+// 以 Apex 为顶点、沿 Direction 方向的圆锥，HalfAngle 为半顶角，单位为弧度，需要小于 pi / 2
+// 只包含距离顶点不超过 MaxDistance 的部分
+class FViewCone
+{
+public:
+    FViewCone(const glm::vec3& Apex, const glm::vec3& Direction, float HalfAngle,
+              float MaxDistance = std::numeric_limits<float>::infinity())
+        :
+        _Apex(Apex),
+        _Direction(glm::normalize(Direction)),
+        _CosHalfAngle(std::cos(HalfAngle)),
+        _SinHalfAngle(std::sin(HalfAngle)),
+        _MaxDistance(MaxDistance)
+    {
+    }
+
+    bool Contains(const glm::vec3& Point) const
+    {
+        glm::vec3 Offset = Point - _Apex;
+        float Axial         = glm::dot(Offset, _Direction);
+        float SquaredLength = glm::dot(Offset, Offset);
+
+        return SquaredLength <= _MaxDistance * _MaxDistance && Axial >= 0.0f &&
+               Axial * Axial >= _CosHalfAngle * _CosHalfAngle * SquaredLength;
+    }
+
+    // 用包围盒的外接球判断是否相离，圆锥是凸的，8 个顶点都在圆锥内时整个包围盒在圆锥内
+    EContainment Classify(const glm::vec3& MinBound, const glm::vec3& MaxBound) const
+    {
+        glm::vec3 Center = (MinBound + MaxBound) * 0.5f;
+        glm::vec3 Offset = Center - _Apex;
+        glm::vec3 Extent = (MaxBound - MinBound) * 0.5f;
+        float SphereRadius = std::sqrt(glm::dot(Extent, Extent));
+        float Length       = std::sqrt(glm::dot(Offset, Offset));
+        if (Length - SphereRadius > _MaxDistance)
+        {
+            return EContainment::kOutside;
+        }
+
+        // 在过轴线和球心的平面内，Axial 和 Radial 是球心沿轴线和垂直于轴线的坐标
+        float Axial  = glm::dot(Offset, _Direction);
+        float Radial = std::sqrt(std::max(Length * Length - Axial * Axial, 0.0f));
+        if (Radial * _CosHalfAngle - Axial * _SinHalfAngle > SphereRadius)
+        {
+            return EContainment::kOutside;
+        }
+
+        // 球心在顶点后方时离圆锥最近的是顶点
+        if (Axial * _CosHalfAngle + Radial * _SinHalfAngle < 0.0f && Length > SphereRadius)
+        {
+            return EContainment::kOutside;
+        }
+
+        for (int Corner = 0; Corner != 8; ++Corner)
+        {
+            glm::vec3 Vertex(Corner & 1 ? MaxBound.x : MinBound.x,
+                             Corner & 2 ? MaxBound.y : MinBound.y,
+                             Corner & 4 ? MaxBound.z : MinBound.z);
+
+            if (!Contains(Vertex))
+            {
+                return EContainment::kIntersect;
+            }
+        }
+
+        return EContainment::kInside;
+    }
+
+    const glm::vec3& GetApex() const
+    {
+        return _Apex;
+    }
+
+private:
+    glm::vec3 _Apex;
+    glm::vec3 _Direction;
+    float     _CosHalfAngle;
+    float     _SinHalfAngle;
+    float     _MaxDistance;
+};
+
+// 八叉树节点。节点不单独分配，全部存放在 TOctree 的连续数组中，父子关系用下标表示
+// 子节点用掩码和第一个子节点的下标表示，存在的子节点按卦限顺序连续存放
+// 位置点和链接存放在 TOctree 的连续数组中，节点只记录自己的区间，内部节点的区间是整个子树的区间
 template <typename LinkTargetType>
 class TOctreeNode
 {
 public:
-    TOctreeNode(const glm::vec3& Center, float Radius, TOctreeNode* Previous)
-        : _Center(Center), _Previous(Previous), _Radius(Radius), _bIsValid(true)
+    static constexpr std::uint32_t kInvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+public:
+    TOctreeNode() = default;
+    TOctreeNode(const glm::vec3& Center, float Radius, std::uint32_t Previous)
+        : _Center(Center), _Radius(Radius), _Previous(Previous)
     {
     }
 
@@ -33,26 +211,31 @@ public:
                 Point.z >= _Center.z - _Radius && Point.z <= _Center.z + _Radius);
     }
 
+    // 卦限编号的第 0、1、2 位分别对应 x、y、z 方向，与子节点的存放顺序和 Morton 码一致
     int CalculateOctant(const glm::vec3& Point) const
     {
         int Octant = 0;
 
-        if (Point.x >= _Center.x) Octant |= 4;
+        if (Point.x >= _Center.x) Octant |= 1;
         if (Point.y >= _Center.y) Octant |= 2;
-        if (Point.z >= _Center.z) Octant |= 1;
+        if (Point.z >= _Center.z) Octant |= 4;
 
         return Octant;
     }
 
     bool IntersectSphere(const glm::vec3& Point, float Radius) const
+    {
+        return GetSquaredDistance(Point) <= Radius * Radius;
+    }
+
+    // Point 到节点包围盒的距离的平方，在盒内时为 0
+    float GetSquaredDistance(const glm::vec3& Point) const
     {
         glm::vec3 MinBound = _Center - glm::vec3(_Radius);
         glm::vec3 MaxBound = _Center + glm::vec3(_Radius);
 
-        glm::vec3 ClosestPoint = glm::clamp(Point, MinBound, MaxBound);
-        float Distance = glm::distance(Point, ClosestPoint);
-
-        return Distance <= Radius;
+        glm::vec3 Offset = Point - glm::clamp(Point, MinBound, MaxBound);
+        return glm::dot(Offset, Offset);
     }
 
     const bool GetValidation() const
@@ -65,383 +248,1094 @@ public:
         return _Center;
     }
 
-    const TOctreeNode* GetPrevious() const
+    float GetRadius() const
     {
-        return _Previous;
+        return _Radius;
     }
 
-    TOctreeNode* GetPrevious()
+    std::uint8_t GetChildMask() const
     {
-        return _Previous;
+        return _ChildMask;
     }
 
-    float GetRadius() const
+    bool HasNext(int Octant) const
     {
-        return _Radius;
+        return (_ChildMask >> Octant) & 1;
     }
 
-    std::unique_ptr<TOctreeNode>& GetNext(int Index)
+    // 位置点在 TOctree::GetPoints 数组中的区间
+    std::uint32_t GetPointOffset() const
     {
-        return _Next[Index];
+        return _PointOffset;
     }
 
-    const std::unique_ptr<TOctreeNode>& GetNext(int Index) const
+    std::uint32_t GetPointCount() const
     {
-        return _Next[Index];
+        return _PointCount;
+    }
+
+    std::uint32_t GetLinkCount() const
+    {
+        return _LinkCount;
+    }
+
+    void SetValidation(bool bValidation)
+    {
+        _bIsValid = bValidation;
     }
 
-    void AddPoint(const glm::vec3& Point)
+    bool IsLeafNode() const
     {
-        _Points.push_back(Point);
+        return _ChildMask == 0;
     }
 
-    void DeletePoint(const glm::vec3& Point)
+private:
+    friend class TOctree<LinkTargetType>;
+
+    glm::vec3     _Center{};
+    float         _Radius{};
+    std::uint32_t _Previous{ kInvalidIndex };
+    std::uint32_t _FirstChild{ kInvalidIndex };
+    std::uint32_t _PointOffset{};
+    std::uint32_t _PointCount{};
+    std::uint32_t _LinkCount{};
+    std::uint8_t  _ChildMask{};
+    bool          _bIsValid{ true };
+};
+
+// 扁平八叉树。节点按层存放，每层内按 Morton 顺序排列，遍历和查询都是顺序访问同一块内存
+// 位置点按所在叶子的 Morton 顺序连续存放，每个位置点对应一个链接槽，链接与位置点的下标一致
+// 树只能整体构建：BuildEmptyTree 构建完全树后用 BuildStorage 按叶子填入位置点，或者用 Build 从位置点构建自适应树
+template <typename LinkTargetType>
+class TOctree
+{
+public:
+    using FNodeType = TOctreeNode<LinkTargetType>;
+
+    struct FQueryResult
+    {
+        glm::vec3       Point;
+        float           SquaredDistance{};
+        LinkTargetType* Link{ nullptr }; // 位置点链接的目标，未链接时为 nullptr
+    };
+
+    // 节点子树的聚合数据，由 BuildAggregates 计算
+    struct FNodeAggregate
+    {
+        glm::vec3     MinBound{};      // 子树中位置点的包围盒，比节点本身小，没有位置点时无意义
+        glm::vec3     MaxBound{};
+        glm::vec3     Centroid{};      // 按光度加权的位置点中心，光度全为 0 时为几何中心
+        float         Luminosity{};    // 光度之和
+        float         MaxLuminosity{};
+        std::uint32_t BrightestPoint{ FNodeType::kInvalidIndex };
+    };
+
+    // 细节层次截断时代替整个子树返回的星团
+    struct FCluster
     {
-        auto it = std::find(_Points.begin(), _Points.end(), Point);
-        if (it != _Points.end())
+        glm::vec3     Centroid;
+        glm::vec3     MinBound;
+        glm::vec3     MaxBound;
+        float         Luminosity{};
+        float         ApparentLuminosity{}; // Luminosity 除以观察点到 Centroid 的距离的平方
+        std::uint32_t PointCount{};
+        FQueryResult  Brightest;            // 最亮的成员，SquaredDistance 为到观察点的距离的平方
+    };
+
+public:
+    TOctree(const glm::vec3& Center, float Radius, int MaxDepth = 8)
+        :
+        _ThreadPool(Runtime::Thread::FThreadPool::GetInstance()),
+        _MaxDepth(std::clamp(MaxDepth, 0, _kMaxMortonDepth))
+    {
+        _Nodes.emplace_back(Center, Radius, FNodeType::kInvalidIndex);
+    }
+
+    // 构建叶子半径不大于 LeafRadius 的完全八叉树，已有的节点和位置点全部清除
+    void BuildEmptyTree(float LeafRadius)
+    {
+        FNodeType Root(_Nodes.front()._Center, _Nodes.front()._Radius, FNodeType::kInvalidIndex);
+        int Depth = std::max(0, static_cast<int>(std::ceil(std::log2(Root._Radius / LeafRadius))));
+
+        std::size_t NodeCount = 0;
+        for (std::size_t Level = 0, LevelSize = 1; Level <= static_cast<std::size_t>(Depth); ++Level, LevelSize *= 8)
+        {
+            NodeCount += LevelSize;
+        }
+
+        if (NodeCount > FNodeType::kInvalidIndex)
         {
-            _Points.erase(it);
+            throw std::length_error("Octree node count exceeds index range.");
+        }
+
+        _Points.clear();
+        _Links.clear();
+        _Aggregates.clear();
+        _Nodes.clear();
+        _Nodes.resize(NodeCount);
+        _Nodes.front() = Root;
+
+        // 第 k 层第 j 个节点的子节点是第 k + 1 层的 [8j, 8j + 8)，每层可以并行填充
+        std::size_t LevelBegin = 0;
+        std::size_t LevelSize  = 1;
+        for (int Level = 0; Level != Depth; ++Level)
+        {
+            std::size_t NextBegin = LevelBegin + LevelSize;
+            Runtime::Thread::ParallelFor(_ThreadPool, _ThreadPool->GetMaxThreadCount(), LevelSize * 8,
+            [&](int, std::size_t Begin, std::size_t End) -> void
+            {
+                for (std::size_t i = Begin; i != End; ++i)
+                {
+                    auto  PreviousIndex = static_cast<std::uint32_t>(LevelBegin + i / 8);
+                    int   Octant        = static_cast<int>(i % 8);
+                    auto& Previous      = _Nodes[PreviousIndex];
+                    float NextRadius    = Previous._Radius * 0.5f;
+
+                    _Nodes[NextBegin + i] = FNodeType(Previous._Center + GetOctantOffset(Octant, NextRadius), NextRadius, PreviousIndex);
+                    if (Octant == 0)
+                    {
+                        Previous._FirstChild = static_cast<std::uint32_t>(NextBegin + i);
+                        Previous._ChildMask  = 0xFF;
+                    }
+                }
+            }, _kMinChunkSize);
+
+            LevelBegin = NextBegin;
+            LevelSize *= 8;
         }
     }
 
-    void RemoveStorage()
+    // 按 Morton 顺序访问每个叶子节点，Generate(FNodeType& Node, std::vector<glm::vec3>& Points) 把该叶子的位置点追加到 Points 末尾
+    // 已有的位置点和链接全部清除。追加的位置点不在该叶子内时抛出 std::out_of_range，否则按位置定位会找不到它
+    template <typename Func>
+    void BuildStorage(Func&& Generate)
     {
         _Points.clear();
+        _Links.clear();
+        _Aggregates.clear();
+
+        std::vector<std::uint32_t> Stack{ 0 };
+        while (!Stack.empty())
+        {
+            FNodeType& Node = _Nodes[Stack.back()];
+            Stack.pop_back();
+
+            if (Node.IsLeafNode())
+            {
+                std::size_t PointOffset = _Points.size();
+                Generate(Node, _Points);
+                if (_Points.size() > FNodeType::kInvalidIndex)
+                {
+                    throw std::length_error("Octree point count exceeds index range.");
+                }
+
+                for (std::size_t PointIndex = PointOffset; PointIndex != _Points.size(); ++PointIndex)
+                {
+                    if (!Node.Contains(_Points[PointIndex]))
+                    {
+                        throw std::out_of_range("Octree point lies outside its leaf node.");
+                    }
+                }
+
+                Node._PointOffset = static_cast<std::uint32_t>(PointOffset);
+                Node._PointCount  = static_cast<std::uint32_t>(_Points.size() - PointOffset);
+                Node._LinkCount   = 0;
+                continue;
+            }
+
+            // 逆序入栈，卦限 0 的子树先出栈
+            for (std::uint32_t i = std::popcount(Node._ChildMask); i != 0; --i)
+            {
+                Stack.push_back(Node._FirstChild + i - 1);
+            }
+        }
+
+        _Links.assign(_Points.size(), nullptr);
+        UpdateStorageRanges();
     }
 
-    void AddLink(LinkTargetType* Target)
+    // 计算每个节点子树的位置点个数以外的聚合数据。GetLuminosity(const glm::vec3& Point, LinkTargetType* Link) 返回位置点的光度，
+    // 会被多个线程同时调用。重新构建树或位置点后聚合数据被清除，链接或光度变化后需要重新计算
+    template <typename Func>
+    void BuildAggregates(Func&& GetLuminosity)
     {
-        _DataLink.push_back(Target);
+        _Aggregates.assign(_Nodes.size(), FNodeAggregate{});
+
+        // 叶子节点之间互不相关，可以并行
+        Runtime::Thread::ParallelFor(_ThreadPool, _ThreadPool->GetMaxThreadCount(), _Nodes.size(),
+        [&](int, std::size_t Begin, std::size_t End) -> void
+        {
+            for (std::size_t Index = Begin; Index != End; ++Index)
+            {
+                const FNodeType& Node = _Nodes[Index];
+                if (!Node.IsLeafNode() || Node._PointCount == 0)
+                {
+                    continue;
+                }
+
+                auto& Aggregate = _Aggregates[Index];
+                Aggregate.MinBound = _Points[Node._PointOffset];
+                Aggregate.MaxBound = _Points[Node._PointOffset];
+
+                glm::vec3 WeightedSum(0.0f);
+                glm::vec3 Sum(0.0f);
+                for (std::uint32_t PointIndex = Node._PointOffset; PointIndex != Node._PointOffset + Node._PointCount; ++PointIndex)
+                {
+                    const glm::vec3& Point = _Points[PointIndex];
+                    float Luminosity = GetLuminosity(Point, _Links[PointIndex]);
+
+                    Aggregate.MinBound    = glm::min(Aggregate.MinBound, Point);
+                    Aggregate.MaxBound    = glm::max(Aggregate.MaxBound, Point);
+                    Aggregate.Luminosity += Luminosity;
+                    WeightedSum          += Point * Luminosity;
+                    Sum                  += Point;
+
+                    if (Aggregate.BrightestPoint == FNodeType::kInvalidIndex || Luminosity > Aggregate.MaxLuminosity)
+                    {
+                        Aggregate.MaxLuminosity  = Luminosity;
+                        Aggregate.BrightestPoint = PointIndex;
+                    }
+                }
+
+                Aggregate.Centroid = Aggregate.Luminosity > 0.0f
+                                   ? WeightedSum / Aggregate.Luminosity
+                                   : Sum / static_cast<float>(Node._PointCount);
+            }
+        }, _kMinChunkSize);
+
+        // 子节点的下标总是大于父节点，逆序合并
+        for (std::size_t Index = _Nodes.size(); Index-- != 0;)
+        {
+            const FNodeType& Node = _Nodes[Index];
+            if (Node.IsLeafNode() || Node._PointCount == 0)
+            {
+                continue;
+            }
+
+            auto& Aggregate = _Aggregates[Index];
+            glm::vec3 WeightedSum(0.0f);
+            glm::vec3 Sum(0.0f);
+            for (std::uint32_t i = 0; i != static_cast<std::uint32_t>(std::popcount(Node._ChildMask)); ++i)
+            {
+                const FNodeType&      Child          = _Nodes[Node._FirstChild + i];
+                const FNodeAggregate& ChildAggregate = _Aggregates[Node._FirstChild + i];
+                if (Child._PointCount == 0)
+                {
+                    continue;
+                }
+
+                if (Aggregate.BrightestPoint == FNodeType::kInvalidIndex)
+                {
+                    Aggregate.MinBound = ChildAggregate.MinBound;
+                    Aggregate.MaxBound = ChildAggregate.MaxBound;
+                }
+
+                Aggregate.MinBound    = glm::min(Aggregate.MinBound, ChildAggregate.MinBound);
+                Aggregate.MaxBound    = glm::max(Aggregate.MaxBound, ChildAggregate.MaxBound);
+                Aggregate.Luminosity += ChildAggregate.Luminosity;
+                WeightedSum          += ChildAggregate.Centroid * ChildAggregate.Luminosity;
+                Sum                  += ChildAggregate.Centroid * static_cast<float>(Child._PointCount);
+
+                if (Aggregate.BrightestPoint == FNodeType::kInvalidIndex || ChildAggregate.MaxLuminosity > Aggregate.MaxLuminosity)
+                {
+                    Aggregate.MaxLuminosity  = ChildAggregate.MaxLuminosity;
+                    Aggregate.BrightestPoint = ChildAggregate.BrightestPoint;
+                }
+            }
+
+            Aggregate.Centroid = Aggregate.Luminosity > 0.0f
+                               ? WeightedSum / Aggregate.Luminosity
+                               : Sum / static_cast<float>(Node._PointCount);
+        }
     }
 
-    template <typename Func>
-    LinkTargetType* GetLink(Func&& Pred) const
+    // 从位置点批量构建自适应树，已有的节点和位置点全部清除
+    // 位置点量化到 2^MaxDepth 的栅格上计算 Morton 码，排序后每个节点对应一段连续的码。位置点多于一个且未到最大深度的节点继续细分，
+    // 只创建有位置点的子节点。有位置点在根节点范围外时抛出 std::out_of_range，树保持不变
+    void Build(std::span<const glm::vec3> Points)
     {
-        for (LinkTargetType* Target : _DataLink)
+        FNodeType Root(_Nodes.front()._Center, _Nodes.front()._Radius, FNodeType::kInvalidIndex);
+
+        std::vector<std::pair<std::uint64_t, glm::vec3>> Codes;
+        Codes.reserve(Points.size());
+        for (const auto& Point : Points)
         {
-            if (Pred(Target))
+            if (!Root.Contains(Point))
             {
-                return Target;
+                throw std::out_of_range("Octree point lies outside the root node.");
             }
+
+            Codes.emplace_back(EncodeMorton(Root, Point, _MaxDepth), Point);
+        }
+
+        if (Codes.size() > FNodeType::kInvalidIndex)
+        {
+            throw std::length_error("Octree point count exceeds index range.");
+        }
+
+        std::stable_sort(Codes.begin(), Codes.end(), [](const auto& Lhs, const auto& Rhs) -> bool
+        {
+            return Lhs.first < Rhs.first;
+        });
+
+        _Points.resize(Codes.size());
+        for (std::size_t i = 0; i != Codes.size(); ++i)
+        {
+            _Points[i] = Codes[i].second;
+        }
+
+        _Links.assign(_Points.size(), nullptr);
+        _Aggregates.clear();
+
+        Root._PointCount = static_cast<std::uint32_t>(Codes.size());
+        _Nodes.clear();
+        _Nodes.push_back(Root);
+
+        // 按层细分，子节点按卦限顺序追加，每层内自然是 Morton 顺序
+        std::size_t LevelBegin = 0;
+        for (int Depth = 0; Depth != _MaxDepth && LevelBegin != _Nodes.size(); ++Depth)
+        {
+            std::size_t LevelEnd = _Nodes.size();
+            int Shift = 3 * (_MaxDepth - Depth - 1);
+            for (std::size_t Index = LevelBegin; Index != LevelEnd; ++Index)
+            {
+                if (_Nodes[Index]._PointCount <= 1)
+                {
+                    continue;
+                }
+
+                std::uint32_t Begin = _Nodes[Index]._PointOffset;
+                std::uint32_t End   = Begin + _Nodes[Index]._PointCount;
+                _Nodes[Index]._FirstChild = static_cast<std::uint32_t>(_Nodes.size());
+                while (Begin != End)
+                {
+                    std::uint64_t Prefix = Codes[Begin].first >> Shift;
+                    auto NextIt = std::partition_point(Codes.begin() + Begin, Codes.begin() + End,
+                    [Prefix, Shift](const auto& Code) -> bool
+                    {
+                        return (Code.first >> Shift) == Prefix;
+                    });
+
+                    auto  Next       = static_cast<std::uint32_t>(NextIt - Codes.begin());
+                    int   Octant     = static_cast<int>(Prefix & 7);
+                    float NextRadius = _Nodes[Index]._Radius * 0.5f;
+
+                    FNodeType Child(_Nodes[Index]._Center + GetOctantOffset(Octant, NextRadius), NextRadius, static_cast<std::uint32_t>(Index));
+                    Child._PointOffset = Begin;
+                    Child._PointCount  = Next - Begin;
+
+                    _Nodes[Index]._ChildMask |= static_cast<std::uint8_t>(1 << Octant);
+                    _Nodes.push_back(Child);
+                    Begin = Next;
+                }
+            }
+
+            if (_Nodes.size() > FNodeType::kInvalidIndex)
+            {
+                throw std::length_error("Octree node count exceeds index range.");
+            }
+
+            LevelBegin = LevelEnd;
+        }
+    }
+
+    // 清空所有节点的位置点和链接，并恢复为有效状态，保留树的结构，可以用于下一次生成
+    void ClearStorage()
+    {
+        for (auto& Node : _Nodes)
+        {
+            Node._PointOffset = 0;
+            Node._PointCount  = 0;
+            Node._LinkCount   = 0;
+            Node._bIsValid    = true;
+        }
+
+        _Points.clear();
+        _Links.clear();
+        _Aggregates.clear();
+    }
+
+    // 链接到叶子节点下一个尚未链接的位置点，第 k 次链接对应该叶子的第 k 个位置点
+    void AddLink(FNodeType& Node, LinkTargetType* Target)
+    {
+        if (!Node.IsLeafNode() || Node._LinkCount == Node._PointCount)
+        {
+            throw std::out_of_range("Octree node has no unlinked point.");
         }
 
-        return nullptr;
+        _Links[Node._PointOffset + Node._LinkCount++] = Target;
     }
 
-    void RemoveLinks()
+    // 把与 Point 的距离不超过 Radius 的位置点追加到 Results，返回追加的个数，Point 本身如果在树中也会返回
+    // MaxResults 不为 0 时最多追加这么多个，达到上限后立即停止，返回的是满足条件的任意一部分，不保证是最近的
+    std::size_t Query(const glm::vec3& Point, float Radius, std::vector<FQueryResult>& Results, std::size_t MaxResults = 0) const
     {
-        _DataLink.clear();
+        std::size_t ResultBegin = Results.size();
+        std::size_t ResultLimit = MaxResults == 0 ? std::numeric_limits<std::size_t>::max() : ResultBegin + MaxResults;
+        if (Radius >= 0.0f)
+        {
+            QueryImpl(0, Point, Radius * Radius, ResultLimit, Results);
+        }
+
+        return Results.size() - ResultBegin;
     }
 
-    std::vector<glm::vec3>& GetPoints()
+    // 视锥体内的全部位置点，SquaredDistance 为到观察点 Viewpoint 的距离的平方，返回追加的个数
+    std::size_t QueryFrustum(const FFrustum& Frustum, const glm::vec3& Viewpoint, std::vector<FQueryResult>& Results) const
     {
-        return _Points;
+        std::size_t ResultBegin = Results.size();
+        QueryVolumeImpl(0, Frustum, Viewpoint, false, 0.0f, Results, nullptr);
+        return Results.size() - ResultBegin;
     }
 
-    const std::vector<glm::vec3>& GetPoints() const
+    // 带细节层次的视锥体查询，需要先调用 BuildAggregates
+    // 子树的光度之和除以观察点到其位置点包围盒的距离的平方小于 MinApparentLuminosity 时，整个子树作为一个星团加入 Clusters，不再展开
+    // 星团的成员不再逐个检查是否在视锥体内。代价与可见的、足够亮的节点数成正比
+    void QueryFrustum(const FFrustum& Frustum, const glm::vec3& Viewpoint, float MinApparentLuminosity,
+                      std::vector<FQueryResult>& Results, std::vector<FCluster>& Clusters) const
     {
-        return _Points;
+        if (!HasAggregates())
+        {
+            throw std::logic_error("Octree aggregates have not been built.");
+        }
+
+        QueryVolumeImpl(0, Frustum, Viewpoint, false, MinApparentLuminosity, Results, &Clusters);
     }
 
-    void SetValidation(bool bValidation)
+    // 圆锥内的全部位置点，SquaredDistance 为到圆锥顶点的距离的平方，返回追加的个数
+    std::size_t QueryCone(const FViewCone& Cone, std::vector<FQueryResult>& Results) const
     {
-        _bIsValid = bValidation;
+        std::size_t ResultBegin = Results.size();
+        QueryVolumeImpl(0, Cone, Cone.GetApex(), false, 0.0f, Results, nullptr);
+        return Results.size() - ResultBegin;
     }
 
-    bool IsLeafNode() const
+    // 带细节层次的圆锥查询，以圆锥顶点为观察点，规则与 QueryFrustum 相同
+    void QueryCone(const FViewCone& Cone, float MinApparentLuminosity, std::vector<FQueryResult>& Results, std::vector<FCluster>& Clusters) const
     {
-        for (const auto& Next : _Next)
+        if (!HasAggregates())
         {
-            if (Next != nullptr)
-            {
-                return false;
-            }
+            throw std::logic_error("Octree aggregates have not been built.");
         }
 
-        return true;
+        QueryVolumeImpl(0, Cone, Cone.GetApex(), false, MinApparentLuminosity, Results, &Clusters);
     }
 
-private:
-    glm::vec3    _Center;
-    TOctreeNode* _Previous;
-    float        _Radius;
-    bool         _bIsValid;
-
-    std::array<std::unique_ptr<TOctreeNode>, 8> _Next;
-    std::vector<glm::vec3>                      _Points;
-    std::vector<LinkTargetType*>                _DataLink;
-};
+    // 距离 Point 最近的至多 Count 个位置点，按距离由近到远追加到 Results，返回追加的个数
+    // 距离大于 MaxDistance 的位置点不返回，Filter(const LinkTargetType* Link) 返回 false 的位置点被跳过，未链接的位置点传入 nullptr
+    // 按节点到 Point 的距离由近到远展开，当前第 Count 近的距离小于剩余节点的最近距离时结束
+    template <typename Func = std::function<bool(const LinkTargetType*)>>
+    std::size_t QueryNearest(const glm::vec3& Point, std::size_t Count, std::vector<FQueryResult>& Results,
+                             float MaxDistance = std::numeric_limits<float>::infinity(),
+                             Func&& Filter = [](const LinkTargetType*) -> bool { return true; }) const
+    {
+        FNearestScratch Scratch;
+        return QueryNearestImpl(Point, Count, MaxDistance, Filter, Scratch, Results);
+    }
 
-template <typename LinkTargetType>
-class TOctree
-{
-public:
-    using FNodeType = TOctreeNode<LinkTargetType>;
+    // 批量最近邻查询，Results[i] 的内容与 QueryNearest(Points[i], ...) 相同，Results 的大小被设为查询点个数
+    // 查询点按 Morton 码排序后分段并行处理，相邻的查询访问相近的节点。Filter 会被多个线程同时调用
+    template <typename Func = std::function<bool(const LinkTargetType*)>>
+    void QueryNearest(std::span<const glm::vec3> Points, std::size_t Count, std::vector<std::vector<FQueryResult>>& Results,
+                      float MaxDistance = std::numeric_limits<float>::infinity(),
+                      Func&& Filter = [](const LinkTargetType*) -> bool { return true; }) const
+    {
+        const FNodeType& Root = _Nodes.front();
+        std::vector<std::pair<std::uint64_t, std::size_t>> Order(Points.size());
+        for (std::size_t i = 0; i != Points.size(); ++i)
+        {
+            Order[i] = { EncodeMorton(Root, Points[i], _kMaxMortonDepth), i };
+        }
 
-public:
-    TOctree(const glm::vec3& Center, float Radius, int MaxDepth = 8)
-        :
-        _Root(std::make_unique<FNodeType>(Center, Radius, nullptr)),
-        _ThreadPool(Runtime::Thread::FThreadPool::GetInstance()),
-        _MaxDepth(MaxDepth)
+        std::sort(Order.begin(), Order.end());
+
+        Results.resize(Points.size());
+        int MaxThread = _ThreadPool->GetMaxThreadCount();
+        std::vector<FNearestScratch> Scratches(MaxThread);
+        Runtime::Thread::ParallelFor(_ThreadPool, MaxThread, Order.size(), [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+        {
+            for (std::size_t i = Begin; i != End; ++i)
+            {
+                std::size_t QueryIndex = Order[i].second;
+                Results[QueryIndex].clear();
+                QueryNearestImpl(Points[QueryIndex], Count, MaxDistance, Filter, Scratches[ThreadId], Results[QueryIndex]);
+            }
+        }, _kMinNearestChunkSize);
+    }
+
+    // 从根节点沿包含 Point 的卦限向下，返回路径上第一个满足 Pred 的节点，只访问 O(深度) 个节点
+    template <typename Func = std::function<bool(const FNodeType&)>>
+    FNodeType* Find(const glm::vec3& Point, Func&& Pred = [](const FNodeType&) -> bool { return true; })
     {
+        std::uint32_t Index = FindImpl(Point, Pred);
+        return Index == FNodeType::kInvalidIndex ? nullptr : &_Nodes[Index];
     }
 
-    void BuildEmptyTree(float LeafRadius)
+    template <typename Func = std::function<bool(const FNodeType&)>>
+    const FNodeType* Find(const glm::vec3& Point, Func&& Pred = [](const FNodeType&) -> bool { return true; }) const
     {
-        int Depth = static_cast<int>(std::ceil(std::log2(_Root->GetRadius() / LeafRadius)));
-        BuildEmptyTreeImpl(_Root.get(), LeafRadius, Depth);
+        std::uint32_t Index = FindImpl(Point, Pred);
+        return Index == FNodeType::kInvalidIndex ? nullptr : &_Nodes[Index];
     }
 
-    void Insert(const glm::vec3& Point)
+    // 包含 Point 的叶子节点，不在树内时返回 nullptr
+    FNodeType* FindLeaf(const glm::vec3& Point)
     {
-        InsertImpl(_Root.get(), Point, 0);
+        return Find(Point, [](const FNodeType& Node) -> bool { return Node.IsLeafNode(); });
     }
 
-    void Delete(const glm::vec3& Point)
+    const FNodeType* FindLeaf(const glm::vec3& Point) const
     {
-        DeleteImpl(_Root.get(), Point);
+        return Find(Point, [](const FNodeType& Node) -> bool { return Node.IsLeafNode(); });
     }
 
-    void Query(const glm::vec3& Point, float Radius, std::vector<glm::vec3>& Results) const
+    // 批量定位叶子节点，Results[i] 与 FindLeaf(Points[i]) 相同
+    // 查询点按 Morton 码排序后分段并行处理，相邻的查询点共享从根节点出发的路径，只有路径分叉以下的节点需要重新访问
+    void FindLeaves(std::span<const glm::vec3> Points, std::span<FNodeType*> Results)
     {
-        QueryImpl(_Root.get(), Point, Radius, Results);
+        FindLeavesImpl(Points, Results.size(), [&](std::size_t QueryIndex, std::uint32_t NodeIndex) -> void
+        {
+            Results[QueryIndex] = NodeIndex == FNodeType::kInvalidIndex ? nullptr : &_Nodes[NodeIndex];
+        });
     }
 
-    template <typename Func = std::function<bool(const FNodeType&)>>
-    FNodeType* Find(const glm::vec3& Point, Func&& Pred = [](const FNodeType&) -> bool { return true; }) const
+    void FindLeaves(std::span<const glm::vec3> Points, std::span<const FNodeType*> Results) const
     {
-        return FindImpl(_Root.get(), Point, std::forward<Func>(Pred));
+        FindLeavesImpl(Points, Results.size(), [&](std::size_t QueryIndex, std::uint32_t NodeIndex) -> void
+        {
+            Results[QueryIndex] = NodeIndex == FNodeType::kInvalidIndex ? nullptr : &_Nodes[NodeIndex];
+        });
+    }
+
+    // 按存放顺序访问全部节点：先按层，层内按 Morton 顺序。叶子节点之间的相对顺序与深度优先遍历相同
+    template <typename Func>
+    void Traverse(Func&& Pred)
+    {
+        for (auto& Node : _Nodes)
+        {
+            Pred(Node);
+        }
     }
 
     template <typename Func>
     void Traverse(Func&& Pred) const
     {
-        TraverseImpl(_Root.get(), std::forward<Func>(Pred));
+        for (const auto& Node : _Nodes)
+        {
+            Pred(Node);
+        }
+    }
+
+    FNodeType* GetNext(const FNodeType& Node, int Octant)
+    {
+        return Node.HasNext(Octant) ? &_Nodes[GetNextIndex(Node, Octant)] : nullptr;
+    }
+
+    const FNodeType* GetNext(const FNodeType& Node, int Octant) const
+    {
+        return Node.HasNext(Octant) ? &_Nodes[GetNextIndex(Node, Octant)] : nullptr;
+    }
+
+    FNodeType* GetPrevious(const FNodeType& Node)
+    {
+        return Node._Previous == FNodeType::kInvalidIndex ? nullptr : &_Nodes[Node._Previous];
+    }
+
+    const FNodeType* GetPrevious(const FNodeType& Node) const
+    {
+        return Node._Previous == FNodeType::kInvalidIndex ? nullptr : &_Nodes[Node._Previous];
+    }
+
+    // 节点的位置点，内部节点返回整个子树的位置点
+    std::span<glm::vec3> GetPoints(const FNodeType& Node)
+    {
+        return { _Points.data() + Node._PointOffset, Node._PointCount };
+    }
+
+    std::span<const glm::vec3> GetPoints(const FNodeType& Node) const
+    {
+        return { _Points.data() + Node._PointOffset, Node._PointCount };
+    }
+
+    // 叶子节点已经链接的目标，第 k 个目标对应该叶子的第 k 个位置点
+    std::span<LinkTargetType* const> GetLinks(const FNodeType& Node) const
+    {
+        return { _Links.data() + Node._PointOffset, Node.IsLeafNode() ? Node._LinkCount : 0 };
+    }
+
+    // 节点的聚合数据，未调用 BuildAggregates 时返回 nullptr
+    const FNodeAggregate* GetAggregate(const FNodeType& Node) const
+    {
+        return HasAggregates() ? &_Aggregates[&Node - _Nodes.data()] : nullptr;
+    }
+
+    bool HasAggregates() const
+    {
+        return !_Nodes.empty() && _Aggregates.size() == _Nodes.size();
     }
 
     std::size_t GetCapacity() const
     {
-        return GetCapacityImpl(_Root.get());
+        std::size_t Capacity = 0;
+        for (const auto& Node : _Nodes)
+        {
+            Capacity += Node.IsLeafNode() && Node._bIsValid ? 1 : 0;
+        }
+
+        return Capacity;
     }
 
     std::size_t GetSize() const
     {
-        return GetSizeImpl(_Root.get());
+        return _Points.size();
+    }
+
+    std::size_t GetNodeCount() const
+    {
+        return _Nodes.size();
+    }
+
+    FNodeType* GetRoot()
+    {
+        return &_Nodes.front();
     }
 
     const FNodeType* const GetRoot() const
     {
-        return _Root.get();
+        return &_Nodes.front();
     }
 
 private:
-    void BuildEmptyTreeImpl(FNodeType* Node, float LeafRadius, int Depth)
+    // 最近邻查询的工作区，批量查询时每个线程复用一份
+    struct FNearestScratch
     {
-        if (Node->GetRadius() <= LeafRadius || Depth == 0)
-        {
-            return;
-        }
+        std::vector<std::pair<float, std::uint32_t>> NodeHeap;   // 待展开的节点，按到查询点距离的平方排成小根堆
+        std::vector<FQueryResult>                    Candidates; // 当前最近的至多 Count 个位置点，按距离排成大根堆
+    };
 
-        std::vector<std::future<void>> Futures;
-        float NextRadius = Node->GetRadius() * 0.5f;
-        for (int i = 0; i != 8; ++i)
-        {
-            glm::vec3 Offset((i & 1 ? 1 : -1) * NextRadius,
-                             (i & 2 ? 1 : -1) * NextRadius,
-                             (i & 4 ? 1 : -1) * NextRadius);
+private:
+    static glm::vec3 GetOctantOffset(int Octant, float Radius)
+    {
+        return glm::vec3((Octant & 1 ? 1 : -1) * Radius,
+                         (Octant & 2 ? 1 : -1) * Radius,
+                         (Octant & 4 ? 1 : -1) * Radius);
+    }
 
-            Node->GetNext(i) = std::make_unique<FNodeType>(Node->GetCenter() + Offset, NextRadius, Node);
-            if (Depth == static_cast<int>(std::ceil(std::log2(_Root->GetRadius() / LeafRadius))))
-            {
-                Futures.push_back(_ThreadPool->Submit(&TOctree::BuildEmptyTreeImpl, this, Node->GetNext(i).get(), LeafRadius, Depth - 1));
-            }
-            else
+    static std::uint32_t GetNextIndex(const FNodeType& Node, int Octant)
+    {
+        return Node._FirstChild + std::popcount(static_cast<std::uint32_t>(Node._ChildMask & ((1u << Octant) - 1)));
+    }
+
+    // 每个坐标量化为 Depth 位，按 x、y、z 的顺序从低到高交错，最高的 3 位是根节点下的卦限
+    static std::uint64_t EncodeMorton(const FNodeType& Root, const glm::vec3& Point, int Depth)
+    {
+        std::uint32_t GridSize = 1u << Depth;
+        glm::vec3 Normalized = (Point - (Root._Center - glm::vec3(Root._Radius))) / (2.0f * Root._Radius);
+
+        std::uint64_t Code = 0;
+        for (int Axis = 0; Axis != 3; ++Axis)
+        {
+            auto Cell = static_cast<std::uint32_t>(std::clamp(Normalized[Axis] * GridSize, 0.0f, static_cast<float>(GridSize - 1)));
+            for (int Bit = 0; Bit != Depth; ++Bit)
             {
-                BuildEmptyTreeImpl(Node->GetNext(i).get(), LeafRadius, Depth - 1);
+                Code |= static_cast<std::uint64_t>((Cell >> Bit) & 1) << (3 * Bit + Axis);
             }
         }
 
-        for (auto& Future : Futures)
-        {
-            Future.get();
-        }
+        return Code;
     }
 
-    void InsertImpl(FNodeType* Node, const glm::vec3& Point, int Depth)
+    // 叶子节点的区间确定后，自底向上把内部节点的区间设为子节点区间之并。子节点的下标总是大于父节点
+    void UpdateStorageRanges()
     {
-        if (!Node->Contains(Point) || Depth > _MaxDepth)
+        for (std::size_t Index = _Nodes.size(); Index-- != 0;)
         {
-            return;
-        }
-
-        if (Node->GetNext(0) == nullptr)
-        {
-            for (int i = 0; i != 8; ++i)
+            auto& Node = _Nodes[Index];
+            if (Node.IsLeafNode())
             {
-                glm::vec3 NewCenter = Node->GetCenter();
-                float Radius = Node->GetRadius();
-                NewCenter.x += (i & 4) ? Radius * 0.5f : -Radius * 0.5f;
-                NewCenter.y += (i & 2) ? Radius * 0.5f : -Radius * 0.5f;
-                NewCenter.z += (i & 1) ? Radius * 0.5f : -Radius * 0.5f;
-                Node->GetNext(i) = std::make_unique<FNodeType>(NewCenter, Radius * 0.5f, Node);
+                continue;
             }
-        }
 
-        int Octant = Node->CalculateOctant(Point);
-        if (Depth == _MaxDepth)
-        {
-            Node->AddPoint(Point);
+            const auto& First = _Nodes[Node._FirstChild];
+            const auto& Last  = _Nodes[Node._FirstChild + std::popcount(Node._ChildMask) - 1];
+            Node._PointOffset = First._PointOffset;
+            Node._PointCount  = Last._PointOffset + Last._PointCount - First._PointOffset;
+            Node._LinkCount   = 0;
         }
-        else
+    }
+
+    // 有聚合数据时用位置点的包围盒，比节点本身更紧
+    std::pair<glm::vec3, glm::vec3> GetOccupiedBounds(std::uint32_t Index) const
+    {
+        if (HasAggregates())
         {
-            InsertImpl(Node->GetNext(Octant).get(), Point, Depth + 1);
+            return { _Aggregates[Index].MinBound, _Aggregates[Index].MaxBound };
         }
+
+        const FNodeType& Node = _Nodes[Index];
+        return { Node._Center - glm::vec3(Node._Radius), Node._Center + glm::vec3(Node._Radius) };
     }
 
-    void DeleteImpl(FNodeType* Node, const glm::vec3& Point)
+    // bInside 表示祖先节点已经整个在查询区域内，子树不再检查。Clusters 为 nullptr 时不做细节层次截断
+    template <typename VolumeType>
+    void QueryVolumeImpl(std::uint32_t Index, const VolumeType& Volume, const glm::vec3& Viewpoint, bool bInside,
+                         float MinApparentLuminosity, std::vector<FQueryResult>& Results, std::vector<FCluster>* Clusters) const
     {
-        if (Node == nullptr)
+        const FNodeType& Node = _Nodes[Index];
+        if (Node._PointCount == 0)
         {
             return;
         }
 
-        if (Node->Contains(Point))
+        auto [MinBound, MaxBound] = GetOccupiedBounds(Index);
+        if (!bInside)
         {
-            if (Node->IsLeafNode())
+            EContainment Containment = Volume.Classify(MinBound, MaxBound);
+            if (Containment == EContainment::kOutside)
             {
-                auto& Points = Node->GetPoints();
-                auto it = std::find(Points.begin(), Points.end(), Point);
-                if (it != Points.end())
-                {
-                    Points.erase(it);
-                }
+                return;
             }
-            else
+
+            bInside = Containment == EContainment::kInside;
+        }
+
+        if (Clusters != nullptr && Node._PointCount > 1)
+        {
+            // 用到包围盒的最近距离估计，子树中任何一部分都不会比这更亮。观察点在包围盒内时总是展开
+            const FNodeAggregate& Aggregate = _Aggregates[Index];
+            glm::vec3 Offset = Viewpoint - glm::clamp(Viewpoint, MinBound, MaxBound);
+            float SquaredDistance = glm::dot(Offset, Offset);
+            if (SquaredDistance > 0.0f && Aggregate.Luminosity < MinApparentLuminosity * SquaredDistance)
             {
-                int Octant = Node->CalculateOctant(Point);
-                DeleteImpl(Node->GetNext(Octant).get(), Point);
+                glm::vec3 CentroidOffset   = Aggregate.Centroid - Viewpoint;
+                glm::vec3 BrightestOffset  = _Points[Aggregate.BrightestPoint] - Viewpoint;
+                float CentroidDistance     = std::max(glm::dot(CentroidOffset, CentroidOffset), SquaredDistance);
+
+                Clusters->push_back(
+                {
+                    .Centroid           = Aggregate.Centroid,
+                    .MinBound           = MinBound,
+                    .MaxBound           = MaxBound,
+                    .Luminosity         = Aggregate.Luminosity,
+                    .ApparentLuminosity = Aggregate.Luminosity / CentroidDistance,
+                    .PointCount         = Node._PointCount,
+                    .Brightest          = { _Points[Aggregate.BrightestPoint], glm::dot(BrightestOffset, BrightestOffset),
+                                            _Links[Aggregate.BrightestPoint] }
+                });
+
+                return;
             }
+        }
 
-            if (Node->IsLeafNode() && Node->GetPoints().empty())
+        if (Node.IsLeafNode())
+        {
+            for (std::uint32_t PointIndex = Node._PointOffset; PointIndex != Node._PointOffset + Node._PointCount; ++PointIndex)
             {
-                for (int i = 0; i != 8; ++i)
+                const glm::vec3& Point = _Points[PointIndex];
+                if (bInside || Volume.Contains(Point))
                 {
-                    auto& Next = Node->GetNext(i);
-                    Next.reset();
+                    glm::vec3 Offset = Point - Viewpoint;
+                    Results.push_back({ Point, glm::dot(Offset, Offset), _Links[PointIndex] });
                 }
             }
+
+            return;
+        }
+
+        for (std::uint32_t i = 0; i != static_cast<std::uint32_t>(std::popcount(Node._ChildMask)); ++i)
+        {
+            QueryVolumeImpl(Node._FirstChild + i, Volume, Viewpoint, bInside, MinApparentLuminosity, Results, Clusters);
         }
     }
 
-    void QueryImpl(FNodeType* Node, const glm::vec3& Point, float Radius, std::vector<glm::vec3>& Results) const
+    // 返回 false 表示结果数已达到上限，调用方不再继续
+    bool QueryImpl(std::uint32_t Index, const glm::vec3& Point, float SquaredRadius,
+                   std::size_t ResultLimit, std::vector<FQueryResult>& Results) const
     {
-        if (Node == nullptr || Node->GetNext(0) == nullptr)
+        const FNodeType& Node = _Nodes[Index];
+        if (Node.IsLeafNode())
         {
-            return;
+            return CollectPointsInSphere(Node._PointOffset, Node._PointCount, Point, SquaredRadius, ResultLimit, Results);
         }
 
-        for (const auto& StoredPoint : Node->GetPoints())
+        for (std::uint32_t i = 0; i != static_cast<std::uint32_t>(std::popcount(Node._ChildMask)); ++i)
         {
-            if (glm::distance(StoredPoint, Point) <= Radius && StoredPoint != Point)
+            if (_Nodes[Node._FirstChild + i].GetSquaredDistance(Point) <= SquaredRadius &&
+                !QueryImpl(Node._FirstChild + i, Point, SquaredRadius, ResultLimit, Results))
             {
-                Results.push_back(StoredPoint);
+                return false;
             }
         }
 
-        for (int i = 0; i != 8; ++i)
+        return true;
+    }
+
+    bool CollectPointsInSphere(std::uint32_t Offset, std::uint32_t Count, const glm::vec3& Point, float SquaredRadius,
+                               std::size_t ResultLimit, std::vector<FQueryResult>& Results) const
+    {
+        return VisitPointsInSphere(Offset, Count, Point, SquaredRadius, [&](std::uint32_t PointIndex, float SquaredDistance) -> bool
         {
-            FNodeType* NextNode = Node->GetNext(i).get();
-            if (NextNode != nullptr && NextNode->IntersectSphere(Point, Radius))
-            {
-                QueryImpl(NextNode, Point, Radius, Results);
-            }
-        }
+            Results.push_back({ _Points[PointIndex], SquaredDistance, _Links[PointIndex] });
+            return Results.size() < ResultLimit;
+        });
     }
 
     template <typename Func>
-    FNodeType* FindImpl(FNodeType* Node, const glm::vec3& Point, Func&& Pred) const
+    std::size_t QueryNearestImpl(const glm::vec3& Point, std::size_t Count, float MaxDistance, Func&& Filter,
+                                 FNearestScratch& Scratch, std::vector<FQueryResult>& Results) const
     {
-        if (Node == nullptr)
+        if (Count == 0 || !(MaxDistance >= 0.0f))
         {
-            return nullptr;
+            return 0;
         }
 
-        if (Node->Contains(Point))
+        auto NodeGreater = [](const auto& Lhs, const auto& Rhs) -> bool
+        {
+            return Lhs.first > Rhs.first;
+        };
+
+        auto CandidateLess = [](const FQueryResult& Lhs, const FQueryResult& Rhs) -> bool
         {
-            if (Pred(*Node))
+            return Lhs.SquaredDistance < Rhs.SquaredDistance;
+        };
+
+        auto& NodeHeap   = Scratch.NodeHeap;
+        auto& Candidates = Scratch.Candidates;
+        NodeHeap.clear();
+        Candidates.clear();
+
+        // 候选数不足 Count 时以 MaxDistance 为界，满了之后以当前第 Count 近的距离为界
+        float MaxSquaredDistance = MaxDistance * MaxDistance;
+        auto GetBound = [&]() -> float
+        {
+            return Candidates.size() < Count ? MaxSquaredDistance : Candidates.front().SquaredDistance;
+        };
+
+        NodeHeap.emplace_back(_Nodes.front().GetSquaredDistance(Point), 0);
+        while (!NodeHeap.empty())
+        {
+            std::pop_heap(NodeHeap.begin(), NodeHeap.end(), NodeGreater);
+            auto [NodeDistance, Index] = NodeHeap.back();
+            NodeHeap.pop_back();
+
+            if (NodeDistance > GetBound())
             {
-                return Node;
+                break;
             }
-        }
 
-        for (int i = 0; i != 8; ++i)
-        {
-            FNodeType* ResultNode = FindImpl(Node->GetNext(i).get(), Point, Pred);
-            if (ResultNode != nullptr)
+            const FNodeType& Node = _Nodes[Index];
+            if (Node.IsLeafNode())
             {
-                return ResultNode;
+                VisitPointsInSphere(Node._PointOffset, Node._PointCount, Point, GetBound(),
+                [&](std::uint32_t PointIndex, float SquaredDistance) -> bool
+                {
+                    // 同一批中先加入的候选可能已经收紧了上界
+                    if (SquaredDistance > GetBound() || !Filter(static_cast<const LinkTargetType*>(_Links[PointIndex])))
+                    {
+                        return true;
+                    }
+
+                    if (Candidates.size() == Count)
+                    {
+                        std::pop_heap(Candidates.begin(), Candidates.end(), CandidateLess);
+                        Candidates.pop_back();
+                    }
+
+                    Candidates.push_back({ _Points[PointIndex], SquaredDistance, _Links[PointIndex] });
+                    std::push_heap(Candidates.begin(), Candidates.end(), CandidateLess);
+                    return true;
+                });
+
+                continue;
+            }
+
+            for (std::uint32_t i = 0; i != static_cast<std::uint32_t>(std::popcount(Node._ChildMask)); ++i)
+            {
+                float ChildDistance = _Nodes[Node._FirstChild + i].GetSquaredDistance(Point);
+                if (ChildDistance <= GetBound())
+                {
+                    NodeHeap.emplace_back(ChildDistance, Node._FirstChild + i);
+                    std::push_heap(NodeHeap.begin(), NodeHeap.end(), NodeGreater);
+                }
             }
         }
 
-        return nullptr;
+        std::sort_heap(Candidates.begin(), Candidates.end(), CandidateLess);
+        Results.insert(Results.end(), Candidates.begin(), Candidates.end());
+        return Candidates.size();
     }
 
+    // 对 _Points 中 [Offset, Offset + Count) 内与 Point 的距离的平方不超过 SquaredRadius 的位置点调用 Visit(PointIndex, SquaredDistance)，
+    // Visit 返回 false 时停止并返回 false。有 SSE2 时每 4 个一批计算距离的平方，余下的逐个计算；没有 SSE2 的平台全部逐个计算
     template <typename Func>
-    void TraverseImpl(FNodeType* Node, Func&& Pred) const
+    bool VisitPointsInSphere(std::uint32_t Offset, std::uint32_t Count, const glm::vec3& Point, float SquaredRadius, Func&& Visit) const
     {
-        if (Node == nullptr)
+        std::uint32_t Index = Offset;
+        std::uint32_t End   = Offset + Count;
+
+#ifdef NPGS_OCTREE_USE_SSE
+        static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "Octree batch query requires tightly packed glm::vec3.");
+
+        __m128 CenterX = _mm_set1_ps(Point.x);
+        __m128 CenterY = _mm_set1_ps(Point.y);
+        __m128 CenterZ = _mm_set1_ps(Point.z);
+        __m128 Limit   = _mm_set1_ps(SquaredRadius);
+        alignas(16) float SquaredDistances[4];
+
+        for (; Index + 4 <= End; Index += 4)
         {
-            return;
-        }
+            // 4 个连续的 vec3 转置为 x、y、z 三组
+            const float* Data = &_Points[Index].x;
+            __m128 A = _mm_loadu_ps(Data);     // x0 y0 z0 x1
+            __m128 B = _mm_loadu_ps(Data + 4); // y1 z1 x2 y2
+            __m128 C = _mm_loadu_ps(Data + 8); // z2 x3 y3 z3
+            __m128 T = _mm_shuffle_ps(B, C, _MM_SHUFFLE(1, 0, 3, 2)); // x2 y2 z2 x3
+            __m128 S = _mm_shuffle_ps(A, B, _MM_SHUFFLE(1, 0, 2, 1)); // y0 z0 y1 z1
+            __m128 U = _mm_shuffle_ps(T, C, _MM_SHUFFLE(3, 2, 2, 1)); // y2 z2 y3 z3
+
+            __m128 DeltaX = _mm_sub_ps(_mm_shuffle_ps(A, T, _MM_SHUFFLE(3, 0, 3, 0)), CenterX);
+            __m128 DeltaY = _mm_sub_ps(_mm_shuffle_ps(S, U, _MM_SHUFFLE(2, 0, 2, 0)), CenterY);
+            __m128 DeltaZ = _mm_sub_ps(_mm_shuffle_ps(S, U, _MM_SHUFFLE(3, 1, 3, 1)), CenterZ);
+            __m128 Squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(DeltaX, DeltaX), _mm_mul_ps(DeltaY, DeltaY)), _mm_mul_ps(DeltaZ, DeltaZ));
+
+            int Mask = _mm_movemask_ps(_mm_cmple_ps(Squared, Limit));
+            if (Mask == 0)
+            {
+                continue;
+            }
 
-        Pred(*Node);
+            _mm_store_ps(SquaredDistances, Squared);
+            for (; Mask != 0; Mask &= Mask - 1)
+            {
+                int Lane = std::countr_zero(static_cast<unsigned>(Mask));
+                if (!Visit(Index + Lane, SquaredDistances[Lane]))
+                {
+                    return false;
+                }
+            }
+        }
+#endif // NPGS_OCTREE_USE_SSE
 
-        for (int i = 0; i != 8; ++i)
+        // 标量路径，与 SSE 路径的结果逐位相同
+        for (; Index != End; ++Index)
         {
-            TraverseImpl(Node->GetNext(i).get(), Pred);
+            glm::vec3 Delta = _Points[Index] - Point;
+            float SquaredDistance = glm::dot(Delta, Delta);
+            if (SquaredDistance <= SquaredRadius && !Visit(Index, SquaredDistance))
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
-    std::size_t GetCapacityImpl(const FNodeType* Node) const
+    // 子节点互不重叠，包含 Point 的只有 CalculateOctant 选出的那一个，不需要回溯
+    template <typename Func>
+    std::uint32_t FindImpl(const glm::vec3& Point, Func&& Pred) const
     {
-        if (Node == nullptr)
+        if (!_Nodes.front().Contains(Point))
         {
-            return 0;
+            return FNodeType::kInvalidIndex;
         }
 
-        if (Node->GetNext(0) == nullptr)
+        std::uint32_t Index = 0;
+        while (true)
         {
-            return Node->GetValidation() ? 1 : 0;
-        }
+            const FNodeType& Node = _Nodes[Index];
+            if (Pred(Node))
+            {
+                return Index;
+            }
 
-        std::size_t Capacity = 0;
-        for (int i = 0; i != 8; ++i)
-        {
-            Capacity += GetCapacityImpl(Node->GetNext(i).get());
-        }
+            int Octant = Node.CalculateOctant(Point);
+            if (!Node.HasNext(Octant))
+            {
+                return FNodeType::kInvalidIndex;
+            }
 
-        return Capacity;
+            Index = GetNextIndex(Node, Octant);
+        }
     }
 
-    std::size_t GetSizeImpl(const FNodeType* Node) const
+    // Emit(QueryIndex, NodeIndex) 对每个查询点调用一次，不在树内的查询点 NodeIndex 为 kInvalidIndex
+    template <typename Func>
+    void FindLeavesImpl(std::span<const glm::vec3> Points, std::size_t ResultCount, Func&& Emit) const
     {
-        if (Node == nullptr)
+        if (ResultCount != Points.size())
         {
-            return 0;
+            throw std::invalid_argument("Result count does not match point count.");
         }
 
-        std::size_t Size = Node->GetPoints().size();
-        for (int i = 0; i != 8; ++i)
+        const FNodeType& Root = _Nodes.front();
+        std::vector<std::pair<std::uint64_t, std::size_t>> Order(Points.size());
+        for (std::size_t i = 0; i != Points.size(); ++i)
         {
-            Size += GetSizeImpl(Node->GetNext(i).get());
+            Order[i] = { EncodeMorton(Root, Points[i], _kMaxMortonDepth), i };
         }
 
-        return Size;
+        std::sort(Order.begin(), Order.end());
+
+        Runtime::Thread::ParallelFor(_ThreadPool, _ThreadPool->GetMaxThreadCount(), Order.size(),
+        [&](int, std::size_t Begin, std::size_t End) -> void
+        {
+            // 上一个查询点从根节点到叶子的路径。新的查询点先找出与路径一致的最长前缀，再从前缀末端继续向下
+            std::vector<std::uint32_t> Path{ 0 };
+            for (std::size_t i = Begin; i != End; ++i)
+            {
+                std::size_t      QueryIndex = Order[i].second;
+                const glm::vec3& Point      = Points[QueryIndex];
+                if (!Root.Contains(Point))
+                {
+                    Emit(QueryIndex, FNodeType::kInvalidIndex);
+                    continue;
+                }
+
+                std::size_t Depth = 1;
+                while (Depth != Path.size())
+                {
+                    const FNodeType& Previous = _Nodes[Path[Depth - 1]];
+                    int Octant = Previous.CalculateOctant(Point);
+                    if (!Previous.HasNext(Octant) || GetNextIndex(Previous, Octant) != Path[Depth])
+                    {
+                        break;
+                    }
+
+                    ++Depth;
+                }
+
+                Path.resize(Depth);
+
+                std::uint32_t NodeIndex = Path.back();
+                while (!_Nodes[NodeIndex].IsLeafNode())
+                {
+                    const FNodeType& Node = _Nodes[NodeIndex];
+                    int Octant = Node.CalculateOctant(Point);
+                    if (!Node.HasNext(Octant))
+                    {
+                        NodeIndex = FNodeType::kInvalidIndex;
+                        break;
+                    }
+
+                    NodeIndex = GetNextIndex(Node, Octant);
+                    Path.push_back(NodeIndex);
+                }
+
+                Emit(QueryIndex, NodeIndex);
+            }
+        }, _kMinChunkSize);
     }
 
 private:
-    std::unique_ptr<FNodeType>    _Root;
+    static constexpr int         _kMaxMortonDepth      = 21; // 3 * 21 位的 Morton 码放得进 64 位整数
+    static constexpr std::size_t _kMinChunkSize        = 4096;
+    static constexpr std::size_t _kMinNearestChunkSize = 64;
+
+private:
+    std::vector<FNodeType>        _Nodes;      // 按层存放，层内按 Morton 顺序，同一节点的子节点连续
+    std::vector<glm::vec3>        _Points;     // 按所在叶子的 Morton 顺序连续存放
+    std::vector<LinkTargetType*>  _Links;      // 与 _Points 一一对应，未链接的为 nullptr
+    std::vector<FNodeAggregate>   _Aggregates; // 与 _Nodes 一一对应，未计算时为空
     Runtime::Thread::FThreadPool* _ThreadPool;
     int                           _MaxDepth;
 };
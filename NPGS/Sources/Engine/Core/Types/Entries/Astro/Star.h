@@ -81,9 +81,14 @@ public:
     using Base = FCelestialBody;
     using Base::Base;
 
-    AStar() = default;
+    AStar()                 = default;
     AStar(const FCelestialBody::FBasicProperties& BasicProperties, const FExtendedProperties& ExtraProperties);
-    ~AStar() = default;
+    AStar(const AStar&)     = default;
+    AStar(AStar&&) noexcept = default;
+    ~AStar()                = default;
+
+    AStar& operator=(const AStar&)     = default;
+    AStar& operator=(AStar&&) noexcept = default;
 
     AStar& SetExtendedProperties(const FExtendedProperties& ExtraProperties);
     const FExtendedProperties& GetExtendedProperties() const;
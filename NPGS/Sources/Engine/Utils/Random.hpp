@@ -15,6 +15,7 @@ public:
     virtual ~TDistribution()                          = default;
     virtual BaseType operator()(RandomEngine& Engine) = 0;
     virtual BaseType Generate(RandomEngine& Engine)   = 0;
+    virtual void Reset()                              = 0; // 清除分布内部缓存的状态，重新播种引擎后需要调用
 };
 
 template <typename BaseType = int, typename RandomEngine = std::mt19937>
@@ -35,6 +36,11 @@ public:
         return operator()(Engine);
     }
 
+    void Reset() override
+    {
+        _Distribution.reset();
+    }
+
 private:
     std::uniform_int_distribution<BaseType> _Distribution;
 };
@@ -57,6 +63,11 @@ public:
         return operator()(Engine);
     }
 
+    void Reset() override
+    {
+        _Distribution.reset();
+    }
+
 private:
     std::uniform_real_distribution<BaseType> _Distribution;
 };
@@ -79,6 +90,18 @@ public:
         return operator()(Engine);
     }
 
+    void Reset() override
+    {
+        _Distribution.reset();
+    }
+
+    // 就地修改参数，并清除缓存的第二个样本，结果与用新参数构造的分布相同
+    void SetParam(BaseType Mean, BaseType Sigma)
+    {
+        _Distribution.param(typename std::normal_distribution<BaseType>::param_type(Mean, Sigma));
+        _Distribution.reset();
+    }
+
 private:
     std::normal_distribution<BaseType> _Distribution;
 };
@@ -101,6 +124,11 @@ public:
         return operator()(Engine);
     }
 
+    void Reset() override
+    {
+        _Distribution.reset();
+    }
+
 private:
     std::lognormal_distribution<BaseType> _Distribution;
 };
@@ -123,6 +151,11 @@ public:
         return operator()(Engine);
     }
 
+    void Reset() override
+    {
+        _Distribution.reset();
+    }
+
 private:
     std::bernoulli_distribution _Distribution;
 };
@@ -0,0 +1,47 @@
+#include "GenerationToken.h"
+
+_NPGS_BEGIN
+
+FGenerationToken::FGenerationToken()
+    :
+    _bCancelled(false),
+    _Phase(EPhase::kIdle),
+    _Completed(0),
+    _Total(0)
+{
+}
+
+void FGenerationToken::Reset()
+{
+    _bCancelled.store(false, std::memory_order_relaxed);
+    _Phase.store(EPhase::kIdle, std::memory_order_relaxed);
+    _Completed.store(0, std::memory_order_relaxed);
+    _Total.store(0, std::memory_order_relaxed);
+}
+
+void FGenerationToken::ThrowIfCancelled() const
+{
+    if (IsCancelled())
+    {
+        throw FGenerationCancelled("Universe generation cancelled.");
+    }
+}
+
+void FGenerationToken::BeginPhase(EPhase Phase, std::size_t Total)
+{
+    _Completed.store(0, std::memory_order_relaxed);
+    _Total.store(Total, std::memory_order_relaxed);
+    _Phase.store(Phase, std::memory_order_relaxed);
+}
+
+FGenerationToken::FProgress FGenerationToken::GetProgress() const
+{
+    return
+    {
+        .Phase     = _Phase.load(std::memory_order_relaxed),
+        .Completed = _Completed.load(std::memory_order_relaxed),
+        .Total     = _Total.load(std::memory_order_relaxed)
+    };
+}
+
+_NPGS_END
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <stdexcept>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+
+// 取消生成时由生成函数抛出，生成状态保持一致，可以重新调用生成函数继续或重新开始
+class FGenerationCancelled : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// 宇宙生成的进度和取消令牌。生成线程写入进度并定期检查取消标志，其他线程（例如 UI）随时轮询和取消
+class FGenerationToken
+{
+public:
+    enum class EPhase : std::uint8_t
+    {
+        kIdle,
+        kSlots,          // 构建八叉树并采样格子
+        kSlotCollection, // 格子排序和分配种子
+        kLinking,        // 链接八叉树和恒星系统
+        kStellarSystems, // 生成恒星系统
+        kCompleted
+    };
+
+    // 各字段分别读取，阶段切换的瞬间可能不属于同一个阶段，只用于显示
+    struct FProgress
+    {
+        EPhase      Phase{ EPhase::kIdle };
+        std::size_t Completed{};
+        std::size_t Total{};
+    };
+
+public:
+    FGenerationToken();
+    ~FGenerationToken() = default;
+
+    void Cancel();
+    // 清除取消标志，之后可以用同一个令牌重新开始生成
+    void Reset();
+    bool IsCancelled() const;
+    void ThrowIfCancelled() const;
+
+    void BeginPhase(EPhase Phase, std::size_t Total);
+    void SetProgress(std::size_t Completed);
+    void AddProgress(std::size_t Count);
+    FProgress GetProgress() const;
+
+private:
+    std::atomic<bool>        _bCancelled;
+    std::atomic<EPhase>      _Phase;
+    std::atomic<std::size_t> _Completed;
+    std::atomic<std::size_t> _Total;
+};
+
+_NPGS_END
+
+#include "GenerationToken.inl"
@@ -0,0 +1,25 @@
+#include "GenerationToken.h"
+
+_NPGS_BEGIN
+
+NPGS_INLINE void FGenerationToken::Cancel()
+{
+    _bCancelled.store(true, std::memory_order_relaxed);
+}
+
+NPGS_INLINE bool FGenerationToken::IsCancelled() const
+{
+    return _bCancelled.load(std::memory_order_relaxed);
+}
+
+NPGS_INLINE void FGenerationToken::SetProgress(std::size_t Completed)
+{
+    _Completed.store(Completed, std::memory_order_relaxed);
+}
+
+NPGS_INLINE void FGenerationToken::AddProgress(std::size_t Count)
+{
+    _Completed.fetch_add(Count, std::memory_order_relaxed);
+}
+
+_NPGS_END
@@ -0,0 +1,534 @@
+#include "OctreeValidation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Engine/Core/System/Spatial/Octree.hpp"
+#include "Engine/Utils/Logger.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    // 链接目标为位置点的光度
+    using FOctree   = System::Spatial::TOctree<float>;
+    using FNodeType = FOctree::FNodeType;
+
+    // 视锥体检查使用的投影参数
+    constexpr float kFieldOfView = 60.0f;
+    constexpr float kAspect      = 16.0f / 9.0f;
+    constexpr float kNear        = 0.5f;
+    constexpr float kFar         = 48.0f;
+
+    struct FCameraSample
+    {
+        glm::vec3 Viewpoint;
+        glm::vec3 Direction;
+        glm::mat4 View;
+        glm::mat4 Projection;
+    };
+
+    void Record(FOctreeValidation::FCheckResult& Result, bool bMatched)
+    {
+        ++Result.CheckCount;
+        Result.MismatchCount += bMatched ? 0 : 1;
+    }
+
+    std::vector<glm::vec3> SortPoints(std::span<const glm::vec3> Points)
+    {
+        std::vector<glm::vec3> Sorted(Points.begin(), Points.end());
+        std::ranges::sort(Sorted, [](const glm::vec3& Lhs, const glm::vec3& Rhs) -> bool
+        {
+            if (Lhs.x != Rhs.x)
+            {
+                return Lhs.x < Rhs.x;
+            }
+
+            return Lhs.y != Rhs.y ? Lhs.y < Rhs.y : Lhs.z < Rhs.z;
+        });
+
+        return Sorted;
+    }
+
+    glm::vec3 GeneratePoint(std::mt19937& RandomEngine, float Extent)
+    {
+        // 逐个抽取，保证不同编译器上的抽取顺序一致
+        std::uniform_real_distribution<float> Coordinate(-Extent, Extent);
+        float x = Coordinate(RandomEngine);
+        float y = Coordinate(RandomEngine);
+        float z = Coordinate(RandomEngine);
+        return glm::vec3(x, y, z);
+    }
+
+    // 每个位置点都能用 FindLeaf 找到包含它的叶子，并且在该叶子的位置点区间内
+    void CheckPointLocation(const FOctree& Octree, FOctreeValidation::FCheckResult& Result)
+    {
+        for (const auto& Point : Octree.GetPoints(*Octree.GetRoot()))
+        {
+            const FNodeType* Leaf = Octree.FindLeaf(Point);
+            if (Leaf == nullptr || !Leaf->Contains(Point))
+            {
+                Record(Result, false);
+                continue;
+            }
+
+            auto LeafPoints = Octree.GetPoints(*Leaf);
+            Record(Result, std::ranges::find(LeafPoints, Point) != LeafPoints.end());
+        }
+    }
+
+    // 把树中第 i 个位置点链接到 Luminosities[i]，暴力计算时按同样的下标取光度
+    void LinkLuminosities(FOctree& Octree, std::vector<float>& Luminosities)
+    {
+        Octree.Traverse([&](FNodeType& Node) -> void
+        {
+            if (!Node.IsLeafNode())
+            {
+                return;
+            }
+
+            for (std::uint32_t i = 0; i != Node.GetPointCount(); ++i)
+            {
+                Octree.AddLink(Node, &Luminosities[Node.GetPointOffset() + i]);
+            }
+        });
+    }
+
+    bool NearlyEqual(float Lhs, float Rhs, float Tolerance = 1e-5f)
+    {
+        return std::abs(Lhs - Rhs) <= Tolerance * std::max(1.0f, std::abs(Rhs));
+    }
+
+    // 随机的观察点和方向。Variant 依次选择 FCamera 使用的无限远投影，以及深度范围为 [-1, 1] 和 [0, 1] 的有限投影
+    FCameraSample GenerateCamera(std::mt19937& RandomEngine, std::size_t Variant, float Extent)
+    {
+        FCameraSample Camera;
+        Camera.Viewpoint = GeneratePoint(RandomEngine, 0.5f * Extent);
+        Camera.Direction = GeneratePoint(RandomEngine, 1.0f);
+        if (glm::dot(Camera.Direction, Camera.Direction) < 0.01f)
+        {
+            Camera.Direction = glm::vec3(0.0f, 0.0f, -1.0f);
+        }
+
+        Camera.Direction = glm::normalize(Camera.Direction);
+        glm::vec3 Up = std::abs(Camera.Direction.y) > 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        Camera.View  = glm::lookAt(Camera.Viewpoint, Camera.Viewpoint + Camera.Direction, Up);
+
+        float FieldOfView = glm::radians(kFieldOfView);
+        switch (Variant % 3)
+        {
+        case 0:
+            Camera.Projection = glm::infinitePerspective(FieldOfView, kAspect, kNear);
+            break;
+        case 1:
+            Camera.Projection = glm::perspectiveRH_NO(FieldOfView, kAspect, kNear, kFar);
+            break;
+        default:
+            Camera.Projection = glm::perspectiveRH_ZO(FieldOfView, kAspect, kNear, kFar);
+            break;
+        }
+
+        return Camera;
+    }
+
+    // 裁剪空间中到视锥体各个边界的最小余量，正数在内，负数在外
+    float GetClipMargin(const glm::vec4& Clip, bool bZeroToOne)
+    {
+        float NearMargin = bZeroToOne ? Clip.z : Clip.z + Clip.w;
+        return std::min({ Clip.w - std::abs(Clip.x), Clip.w - std::abs(Clip.y), NearMargin, Clip.w - Clip.z });
+    }
+
+    // FromMatrix 得到的平面与裁剪空间的判断一致：按矩阵自身深度范围可见的点都被保留，
+    // 保留的点满足 -w <= z，深度范围为 [0, 1] 时多保留的点离观察点不近于一半近距离。余量接近 0 的点舍入后可能落在任意一侧，不比较
+    void CheckFrustumPlanes(const FCameraSample& Camera, const System::Spatial::FFrustum& Frustum,
+                            std::mt19937& RandomEngine, float Extent, FOctreeValidation::FCheckResult& Result)
+    {
+        glm::mat4 Matrix = Camera.Projection * Camera.View;
+
+        // 近平面上的点在深度范围为 [0, 1] 时 z 为 0，为 [-1, 1] 时 z 为 -w
+        glm::vec4 NearClip = Matrix * glm::vec4(Camera.Viewpoint + Camera.Direction * kNear, 1.0f);
+        bool bZeroToOne = std::abs(NearClip.z) < 0.5f * NearClip.w;
+
+        for (int i = 0; i != 256; ++i)
+        {
+            // 一半的点在观察点附近，覆盖近平面
+            glm::vec3 Point = i % 2 == 0 ? GeneratePoint(RandomEngine, Extent)
+                                         : Camera.Viewpoint + GeneratePoint(RandomEngine, 2.0f * kNear);
+
+            glm::vec4 Clip      = Matrix * glm::vec4(Point, 1.0f);
+            float     Tolerance = 1e-4f * (std::abs(Clip.w) + 1.0f);
+            float     Margin    = GetClipMargin(Clip, bZeroToOne);
+            float     NoMargin  = GetClipMargin(Clip, false);
+            bool      bContains = Frustum.Contains(Point);
+
+            if (Margin > Tolerance)
+            {
+                Record(Result, bContains);
+            }
+
+            if (std::abs(NoMargin) > Tolerance)
+            {
+                Record(Result, bContains == (NoMargin > 0.0f));
+            }
+
+            if (bZeroToOne && bContains)
+            {
+                float Depth = -(Camera.View * glm::vec4(Point, 1.0f)).z;
+                Record(Result, Depth >= 0.5f * kNear * (1.0f - 1e-4f));
+            }
+        }
+    }
+
+    // 暴力计算区域内全部位置点的下标，下标与 LinkLuminosities 的链接一致
+    template <typename VolumeType>
+    std::vector<std::size_t> CollectContained(const VolumeType& Volume, std::span<const glm::vec3> StoredPoints)
+    {
+        std::vector<std::size_t> Indices;
+        for (std::size_t i = 0; i != StoredPoints.size(); ++i)
+        {
+            if (Volume.Contains(StoredPoints[i]))
+            {
+                Indices.push_back(i);
+            }
+        }
+
+        return Indices;
+    }
+
+    // 查询结果的位置点下标，按下标排序，同时检查到观察点的距离
+    std::vector<std::size_t> GetResultIndices(const std::vector<FOctree::FQueryResult>& Results, const glm::vec3& Viewpoint,
+                                              const float* Luminosities, FOctreeValidation::FCheckResult& Result)
+    {
+        std::vector<std::size_t> Indices;
+        bool bDistanceMatched = true;
+        for (const auto& QueryResult : Results)
+        {
+            glm::vec3 Offset = QueryResult.Point - Viewpoint;
+            bDistanceMatched = bDistanceMatched && QueryResult.Link != nullptr &&
+                               NearlyEqual(QueryResult.SquaredDistance, glm::dot(Offset, Offset));
+            Indices.push_back(QueryResult.Link != nullptr ? QueryResult.Link - Luminosities : 0);
+        }
+
+        Record(Result, bDistanceMatched);
+        std::ranges::sort(Indices);
+        return Indices;
+    }
+
+    // 带细节层次的查询：返回的位置点都在区域内，区域内未返回的位置点都在某个星团的包围盒内，
+    // 每个星团都满足截断条件，MinApparentLuminosity 为 0 时不截断。未返回的位置点较多时等间隔抽查
+    void CheckLodResults(const std::vector<std::size_t>& Contained, const std::vector<std::size_t>& Returned,
+                         const std::vector<FOctree::FCluster>& Clusters, const glm::vec3& Viewpoint, float MinApparentLuminosity,
+                         std::span<const glm::vec3> StoredPoints, FOctreeValidation::FCheckResult& Result)
+    {
+        Record(Result, std::ranges::includes(Contained, Returned));
+        Record(Result, MinApparentLuminosity > 0.0f || Clusters.empty());
+
+        for (const auto& Cluster : Clusters)
+        {
+            glm::vec3 Offset = Viewpoint - glm::clamp(Viewpoint, Cluster.MinBound, Cluster.MaxBound);
+            float SquaredDistance = glm::dot(Offset, Offset);
+            Record(Result, SquaredDistance > 0.0f && Cluster.Luminosity < MinApparentLuminosity * SquaredDistance &&
+                           Cluster.ApparentLuminosity < MinApparentLuminosity && Cluster.PointCount > 1);
+        }
+
+        std::vector<std::size_t> Missing;
+        std::ranges::set_difference(Contained, Returned, std::back_inserter(Missing));
+
+        std::size_t Stride = std::max(Missing.size() / 64, static_cast<std::size_t>(1));
+        for (std::size_t i = 0; i < Missing.size(); i += Stride)
+        {
+            const glm::vec3& Point = StoredPoints[Missing[i]];
+            Record(Result, std::ranges::any_of(Clusters, [&Point](const FOctree::FCluster& Cluster) -> bool
+            {
+                return glm::clamp(Point, Cluster.MinBound, Cluster.MaxBound) == Point;
+            }));
+        }
+    }
+
+    // 每个节点的聚合数据与其子树位置点的暴力计算一致，光度之和的求和顺序不同，允许舍入误差
+    void CheckAggregates(const FOctree& Octree, FOctreeValidation::FCheckResult& Result)
+    {
+        auto RootLinks = Octree.GetLinks(*Octree.GetRoot());
+        Octree.Traverse([&](const FNodeType& Node) -> void
+        {
+            auto Points = Octree.GetPoints(Node);
+            auto Links  = Octree.GetLinks(Node);
+            if (Points.empty())
+            {
+                return;
+            }
+
+            double    Luminosity    = 0.0;
+            float     MaxLuminosity = 0.0f;
+            glm::vec3 MinBound      = Points.front();
+            glm::vec3 MaxBound      = Points.front();
+            for (std::size_t i = 0; i != Points.size(); ++i)
+            {
+                Luminosity   += *Links[i];
+                MaxLuminosity = std::max(MaxLuminosity, *Links[i]);
+                MinBound      = glm::min(MinBound, Points[i]);
+                MaxBound      = glm::max(MaxBound, Points[i]);
+            }
+
+            const auto* Aggregate = Octree.GetAggregate(Node);
+            Record(Result, Aggregate != nullptr && NearlyEqual(Aggregate->Luminosity, static_cast<float>(Luminosity), 1e-4f) &&
+                           Aggregate->MaxLuminosity == MaxLuminosity && Aggregate->MinBound == MinBound &&
+                           Aggregate->MaxBound == MaxBound && *RootLinks[Aggregate->BrightestPoint] == MaxLuminosity);
+        });
+    }
+
+    // 批量定位的结果与逐个 FindLeaf 相同，包括根节点范围外的查询点
+    template <typename OctreeType>
+    void CheckBatchLocation(OctreeType& Octree, std::span<const glm::vec3> Queries, FOctreeValidation::FCheckResult& Result)
+    {
+        using FNodePointer = decltype(Octree.FindLeaf(glm::vec3(0.0f)));
+
+        std::vector<FNodePointer> Leaves(Queries.size());
+        Octree.FindLeaves(Queries, std::span<FNodePointer>(Leaves));
+        for (std::size_t i = 0; i != Queries.size(); ++i)
+        {
+            Record(Result, Leaves[i] == Octree.FindLeaf(Queries[i]));
+        }
+    }
+}
+
+// OctreeValidation implementations
+// --------------------------------
+FOctreeValidation::FOctreeValidation(const FValidationInfo& Info)
+    : _Info(Info)
+{
+}
+
+std::vector<FOctreeValidation::FCheckResult> FOctreeValidation::Run() const
+{
+    std::mt19937 RandomEngine(_Info.Seed);
+
+    std::vector<glm::vec3> Points(_Info.PointCount);
+    for (auto& Point : Points)
+    {
+        Point = GeneratePoint(RandomEngine, _kRootRadius);
+    }
+
+    std::vector<FCheckResult> Results;
+
+    // 同一组位置点的两种构建方式：Build 得到的自适应树，以及 BuildEmptyTree 和 BuildStorage 得到的完全树
+    NpgsCoreInfo("Octree validation: building trees from {} points...", Points.size());
+    FOctree AdaptiveTree(glm::vec3(0.0f), _kRootRadius, _kMaxDepth);
+    AdaptiveTree.Build(Points);
+
+    FOctree CompleteTree(glm::vec3(0.0f), _kRootRadius);
+    CompleteTree.BuildEmptyTree(_kLeafRadius);
+
+    // 先在空树上按 FindLeaf 把位置点分到叶子，BuildStorage 按叶子取回
+    const FNodeType* CompleteRoot = CompleteTree.GetRoot();
+    std::vector<std::vector<glm::vec3>> LeafPoints(CompleteTree.GetNodeCount());
+    for (const auto& Point : Points)
+    {
+        LeafPoints[CompleteTree.FindLeaf(Point) - CompleteRoot].push_back(Point);
+    }
+
+    auto FillLeaf = [&](const FNodeType& Node, std::vector<glm::vec3>& Storage) -> void
+    {
+        const auto& Bucket = LeafPoints[&Node - CompleteRoot];
+        Storage.insert(Storage.end(), Bucket.begin(), Bucket.end());
+    };
+
+    CompleteTree.BuildStorage(FillLeaf);
+
+    FCheckResult BuildResult{ .Name = "Build" };
+    std::vector<glm::vec3> SortedPoints = SortPoints(Points);
+    Record(BuildResult, SortPoints(AdaptiveTree.GetPoints(*AdaptiveTree.GetRoot())) == SortedPoints);
+    Record(BuildResult, SortPoints(CompleteTree.GetPoints(*CompleteTree.GetRoot())) == SortedPoints);
+    CheckPointLocation(AdaptiveTree, BuildResult);
+    CheckPointLocation(CompleteTree, BuildResult);
+
+    // 范围外的位置点使 Build 抛出异常，树保持不变
+    try
+    {
+        std::vector<glm::vec3> OutsidePoints{ glm::vec3(0.0f), glm::vec3(2.0f * _kRootRadius, 0.0f, 0.0f) };
+        AdaptiveTree.Build(OutsidePoints);
+        Record(BuildResult, false);
+    }
+    catch (const std::out_of_range&)
+    {
+        Record(BuildResult, AdaptiveTree.GetSize() == Points.size());
+    }
+
+    Results.push_back(std::move(BuildResult));
+
+    // 查询点包括随机点和树中的全部位置点，随机点有一部分在根节点范围外
+    FCheckResult FindLeavesResult{ .Name = "FindLeaves" };
+    std::vector<glm::vec3> Queries(Points);
+    for (std::size_t i = 0; i != _Info.QueryCount; ++i)
+    {
+        Queries.push_back(GeneratePoint(RandomEngine, 1.25f * _kRootRadius));
+    }
+
+    CheckBatchLocation(AdaptiveTree, Queries, FindLeavesResult);
+    CheckBatchLocation(std::as_const(CompleteTree), Queries, FindLeavesResult);
+    Results.push_back(std::move(FindLeavesResult));
+
+    // 光度按指数分布抽取，只有一部分位置点能通过最近邻查询的过滤条件
+    std::exponential_distribution<float> LuminosityDistribution(1.0f);
+    std::vector<float> Luminosities(AdaptiveTree.GetSize());
+    for (auto& Luminosity : Luminosities)
+    {
+        Luminosity = LuminosityDistribution(RandomEngine);
+    }
+
+    LinkLuminosities(AdaptiveTree, Luminosities);
+    auto StoredPoints = AdaptiveTree.GetPoints(*AdaptiveTree.GetRoot());
+
+    // 最近邻查询的距离序列与暴力排序的前 Count 个相同，覆盖距离上限和过滤条件
+    NpgsCoreInfo("Octree validation: checking nearest neighbour queries...");
+    FCheckResult NearestResult{ .Name = "QueryNearest" };
+    std::vector<glm::vec3> NearestQueries;
+    std::vector<FOctree::FQueryResult> Nearest;
+    std::vector<float> BruteForce;
+    for (std::size_t Query = 0; Query != _Info.QueryCount; ++Query)
+    {
+        glm::vec3 Point = GeneratePoint(RandomEngine, 1.1f * _kRootRadius);
+        NearestQueries.push_back(Point);
+
+        std::size_t Count       = Query % 16 + 1;
+        float       MaxDistance = Query % 3 == 0 ? 8.0f : std::numeric_limits<float>::infinity();
+        bool        bFiltered   = Query % 2 == 1;
+        auto Filter = [bFiltered](const float* Luminosity) -> bool
+        {
+            return !bFiltered || (Luminosity != nullptr && *Luminosity > 1.0f);
+        };
+
+        Nearest.clear();
+        AdaptiveTree.QueryNearest(Point, Count, Nearest, MaxDistance, Filter);
+
+        BruteForce.clear();
+        for (std::size_t i = 0; i != StoredPoints.size(); ++i)
+        {
+            glm::vec3 Offset = StoredPoints[i] - Point;
+            float SquaredDistance = glm::dot(Offset, Offset);
+            if (SquaredDistance <= MaxDistance * MaxDistance && Filter(&Luminosities[i]))
+            {
+                BruteForce.push_back(SquaredDistance);
+            }
+        }
+
+        std::ranges::sort(BruteForce);
+        BruteForce.resize(std::min(BruteForce.size(), Count));
+
+        Record(NearestResult, Nearest.size() == BruteForce.size());
+        for (std::size_t i = 0; i != std::min(Nearest.size(), BruteForce.size()); ++i)
+        {
+            glm::vec3 Offset = Nearest[i].Point - Point;
+            Record(NearestResult, NearlyEqual(Nearest[i].SquaredDistance, BruteForce[i]) &&
+                                  NearlyEqual(glm::dot(Offset, Offset), Nearest[i].SquaredDistance) &&
+                                  Nearest[i].Link != nullptr && Filter(Nearest[i].Link));
+        }
+    }
+
+    // 批量查询与逐个查询的结果完全相同
+    std::vector<std::vector<FOctree::FQueryResult>> BatchNearest;
+    AdaptiveTree.QueryNearest(NearestQueries, 4, BatchNearest);
+    for (std::size_t Query = 0; Query != NearestQueries.size(); ++Query)
+    {
+        Nearest.clear();
+        AdaptiveTree.QueryNearest(NearestQueries[Query], 4, Nearest);
+        Record(NearestResult, BatchNearest[Query].size() == Nearest.size() &&
+                              std::ranges::equal(BatchNearest[Query], Nearest, [](const auto& Lhs, const auto& Rhs) -> bool
+                              {
+                                  return Lhs.SquaredDistance == Rhs.SquaredDistance && Lhs.Link == Rhs.Link;
+                              }));
+    }
+
+    Results.push_back(std::move(NearestResult));
+
+    FCheckResult AggregateResult{ .Name = "BuildAggregates" };
+    AdaptiveTree.BuildAggregates([](const glm::vec3&, const float* Luminosity) -> float
+    {
+        return Luminosity != nullptr ? *Luminosity : 0.0f;
+    });
+
+    CheckAggregates(AdaptiveTree, AggregateResult);
+    Results.push_back(std::move(AggregateResult));
+
+    // 视锥体和圆锥查询与暴力计算比较，带细节层次的查询检查截断规则。暴力计算较慢，查询次数为其他查询的十分之一
+    NpgsCoreInfo("Octree validation: checking frustum and cone queries...");
+    FCheckResult PlaneResult{ .Name = "FromMatrix" };
+    FCheckResult FrustumResult{ .Name = "QueryFrustum" };
+    FCheckResult ConeResult{ .Name = "QueryCone" };
+    FCheckResult LodResult{ .Name = "LevelOfDetail" };
+    std::uniform_real_distribution<float> HalfAngleDistribution(0.1f, 1.2f);
+    std::vector<FOctree::FQueryResult> VolumeResults;
+    std::vector<FOctree::FCluster> Clusters;
+    std::size_t VolumeQueryCount = std::max(_Info.QueryCount / 10, static_cast<std::size_t>(1));
+    for (std::size_t Query = 0; Query != VolumeQueryCount; ++Query)
+    {
+        FCameraSample Camera = GenerateCamera(RandomEngine, Query, _kRootRadius);
+        auto Frustum = System::Spatial::FFrustum::FromMatrix(Camera.Projection * Camera.View);
+        CheckFrustumPlanes(Camera, Frustum, RandomEngine, _kRootRadius, PlaneResult);
+
+        float MinApparentLuminosity = Query % 4 == 0 ? 0.0f : std::pow(10.0f, -static_cast<float>(Query % 4));
+
+        std::vector<std::size_t> Contained = CollectContained(Frustum, StoredPoints);
+        VolumeResults.clear();
+        AdaptiveTree.QueryFrustum(Frustum, Camera.Viewpoint, VolumeResults);
+        Record(FrustumResult, GetResultIndices(VolumeResults, Camera.Viewpoint, Luminosities.data(), FrustumResult) == Contained);
+
+        VolumeResults.clear();
+        Clusters.clear();
+        AdaptiveTree.QueryFrustum(Frustum, Camera.Viewpoint, MinApparentLuminosity, VolumeResults, Clusters);
+        CheckLodResults(Contained, GetResultIndices(VolumeResults, Camera.Viewpoint, Luminosities.data(), LodResult),
+                        Clusters, Camera.Viewpoint, MinApparentLuminosity, StoredPoints, LodResult);
+
+        float MaxDistance = Query % 2 == 0 ? 40.0f : std::numeric_limits<float>::infinity();
+        System::Spatial::FViewCone Cone(Camera.Viewpoint, Camera.Direction, HalfAngleDistribution(RandomEngine), MaxDistance);
+
+        Contained = CollectContained(Cone, StoredPoints);
+        VolumeResults.clear();
+        AdaptiveTree.QueryCone(Cone, VolumeResults);
+        Record(ConeResult, GetResultIndices(VolumeResults, Camera.Viewpoint, Luminosities.data(), ConeResult) == Contained);
+
+        VolumeResults.clear();
+        Clusters.clear();
+        AdaptiveTree.QueryCone(Cone, MinApparentLuminosity, VolumeResults, Clusters);
+        CheckLodResults(Contained, GetResultIndices(VolumeResults, Camera.Viewpoint, Luminosities.data(), LodResult),
+                        Clusters, Camera.Viewpoint, MinApparentLuminosity, StoredPoints, LodResult);
+    }
+
+    Results.push_back(std::move(PlaneResult));
+    Results.push_back(std::move(FrustumResult));
+    Results.push_back(std::move(ConeResult));
+    Results.push_back(std::move(LodResult));
+
+    // ClearStorage 之后树为空，重新填入得到与之前完全相同的存储
+    FCheckResult ClearResult{ .Name = "ClearStorage" };
+    auto CompletePoints = CompleteTree.GetPoints(*CompleteRoot);
+    std::vector<glm::vec3> PreviousPoints(CompletePoints.begin(), CompletePoints.end());
+    CompleteTree.ClearStorage();
+
+    bool bCleared = CompleteTree.GetSize() == 0;
+    CompleteTree.Traverse([&bCleared](const FNodeType& Node) -> void
+    {
+        bCleared = bCleared && Node.GetPointCount() == 0;
+    });
+
+    Record(ClearResult, bCleared);
+    CompleteTree.BuildStorage(FillLeaf);
+    CompletePoints = CompleteTree.GetPoints(*CompleteRoot);
+    Record(ClearResult, std::ranges::equal(CompletePoints, PreviousPoints));
+    Results.push_back(std::move(ClearResult));
+
+    return Results;
+}
+
+_NPGS_END
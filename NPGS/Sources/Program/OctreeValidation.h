@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+
+// 在随机位置点上检查 TOctree 的构建和查询，结果与逐点暴力计算的结果比较
+// 不依赖窗口和星表数据，可以在命令行中运行
+class FOctreeValidation
+{
+public:
+    struct FValidationInfo
+    {
+        std::uint32_t Seed{};
+        std::size_t   PointCount{};
+        std::size_t   QueryCount{}; // 每种查询的随机查询次数
+    };
+
+    struct FCheckResult
+    {
+        std::string Name;
+        std::size_t CheckCount{};    // 比较的次数
+        std::size_t MismatchCount{}; // 与暴力计算不一致的次数
+    };
+
+public:
+    explicit FOctreeValidation(const FValidationInfo& Info);
+    ~FOctreeValidation() = default;
+
+    std::vector<FCheckResult> Run() const;
+
+private:
+    static constexpr float _kRootRadius = 64.0f;
+    static constexpr float _kLeafRadius = 2.0f;
+    static constexpr int   _kMaxDepth   = 12;
+
+private:
+    FValidationInfo _Info;
+};
+
+_NPGS_END
@@ -0,0 +1,415 @@
+#include "StellarStatistics.h"
+
+#include <cmath>
+#include <algorithm>
+#include <format>
+#include <numeric>
+#include <print>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Engine/Core/Math/NumericConstants.h"
+#include "Engine/Core/Runtime/Threads/Parallel.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    void UpdateExtreme(double Value, const Astro::AStar* Star, FStellarStatistics::FExtremeStar& Extreme)
+    {
+        // 严格大于才替换，并列时保留先出现的恒星
+        if (Extreme.Value < Value)
+        {
+            Extreme.Value = Value;
+            Extreme.Star  = Star;
+        }
+    }
+
+    void MergeExtreme(FStellarStatistics::FExtremeStar& Extreme, const FStellarStatistics::FExtremeStar& Other)
+    {
+        UpdateExtreme(Other.Value, Other.Star, Extreme);
+    }
+
+    std::string FormatTitle()
+    {
+        return std::format("{:>6} {:>6} {:>8} {:>8} {:7} {:>5} {:>13} {:>8} {:>8} {:>11} {:>8} {:>9} {:>5} {:>15} {:>9} {:>8}",
+                           "InMass", "Mass", "Radius", "Age", "Class", "FeH", "Lum", "Teff", "CoreTemp", "CoreDensity", "Mdot", "WindSpeed", "Phase", "Magnetic", "Lifetime", "Oblateness");
+    }
+
+    std::string FormatInfo(const Astro::AStar* Star)
+    {
+        if (Star == nullptr)
+        {
+            return "No star generated.";
+        }
+
+        return std::format("{:6.2f} {:6.2f} {:8.2f} {:8.2E} {:7} {:5.2f} {:13.4f} {:8.1f} {:8.2E} {:11.2E} {:8.2E} {:9} {:5} {:15.5f} {:9.2E} {:8.2f}",
+                           Star->GetInitialMass() / kSolarMass,
+                           Star->GetMass() / kSolarMass,
+                           Star->GetRadius() / kSolarRadius,
+                           Star->GetAge(),
+                           Star->GetStellarClass().ToString(),
+                           Star->GetFeH(),
+                           Star->GetLuminosity() / kSolarLuminosity,
+                           Star->GetTeff(),
+                           Star->GetCoreTemp(),
+                           Star->GetCoreDensity(),
+                           Star->GetStellarWindMassLossRate() * kYearToSecond / kSolarMass,
+                           static_cast<int>(std::round(Star->GetStellarWindSpeed())),
+                           static_cast<int>(Star->GetEvolutionPhase()),
+                           Star->GetSurfaceZ(),
+                           Star->GetLifetime(),
+                           Star->GetOblateness());
+    }
+}
+
+// StellarStatistics implementations
+// ---------------------------------
+const FStellarStatistics::FCategoryResult& FStellarStatistics::FResult::operator[](EStarCategory Category) const
+{
+    return Categories[static_cast<std::size_t>(Category)];
+}
+
+std::size_t FStellarStatistics::RegisterAccumulator(std::unique_ptr<IAccumulator>&& Prototype)
+{
+    _Prototypes.push_back(std::move(Prototype));
+    return _Prototypes.size() - 1;
+}
+
+FStellarStatistics::FResult FStellarStatistics::CreateResult() const
+{
+    FResult Result;
+    for (const auto& Prototype : _Prototypes)
+    {
+        Result.Accumulators.push_back(Prototype->Clone());
+    }
+
+    return Result;
+}
+
+template <typename Func>
+FStellarStatistics::FResult
+FStellarStatistics::ComputeImpl(std::size_t SystemCount, Func&& GetSystem, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const
+{
+    MaxThread = std::max(MaxThread, 1);
+
+    std::vector<FResult> LocalResults;
+    LocalResults.reserve(MaxThread);
+    for (int i = 0; i != MaxThread; ++i)
+    {
+        LocalResults.push_back(CreateResult());
+    }
+
+    // map：每个线程统计一段连续的恒星系统
+    Runtime::Thread::ForEachThreadRange(ThreadPool, MaxThread, SystemCount,
+    [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+    {
+        auto& LocalResult = LocalResults[ThreadId];
+        for (std::size_t Index = Begin; Index != End; ++Index)
+        {
+            auto& System = GetSystem(Index);
+            for (const auto& Star : System.StarsData())
+            {
+                Accumulate(System, *Star, LocalResult);
+                for (auto& Accumulator : LocalResult.Accumulators)
+                {
+                    Accumulator->Accumulate(System, *Star);
+                }
+            }
+        }
+    });
+
+    // reduce：按区间顺序合并
+    FResult& Result = LocalResults.front();
+    for (int i = 1; i != MaxThread; ++i)
+    {
+        Merge(Result, LocalResults[i]);
+    }
+
+    return std::move(Result);
+}
+
+FStellarStatistics::FResult
+FStellarStatistics::Compute(std::span<Astro::FStellarSystem> Systems, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const
+{
+    return ComputeImpl(Systems.size(), [Systems](std::size_t Index) -> Astro::FStellarSystem&
+    {
+        return Systems[Index];
+    }, ThreadPool, MaxThread);
+}
+
+FStellarStatistics::FResult
+FStellarStatistics::Compute(std::span<Astro::FStellarSystem* const> Systems, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const
+{
+    return ComputeImpl(Systems.size(), [Systems](std::size_t Index) -> Astro::FStellarSystem&
+    {
+        return *Systems[Index];
+    }, ThreadPool, MaxThread);
+}
+
+void FStellarStatistics::Print(const FResult& Result)
+{
+    constexpr std::array<std::pair<EStarCategory, const char*>, 7> kCategories
+    {
+        std::pair{ EStarCategory::kMainSequence, "main sequence" },
+        std::pair{ EStarCategory::kWolfRayet,    "Wolf-Rayet"    },
+        std::pair{ EStarCategory::kSubgiant,     "subgiant"      },
+        std::pair{ EStarCategory::kGiant,        "giant"         },
+        std::pair{ EStarCategory::kBrightGiant,  "bright giant"  },
+        std::pair{ EStarCategory::kSupergiant,   "supergiant"    },
+        std::pair{ EStarCategory::kHypergiant,   "hypergiant"    }
+    };
+
+    auto PrintExtremes = [&](const char* Title, const char* Property, auto Member) -> void
+    {
+        for (const auto& [Category, Name] : kCategories)
+        {
+            const FExtremeStar& Extreme = Result[Category].*Member;
+            std::println("{} {} star: {}: {}", Title, Name, Property, Extreme.Value);
+            std::println("{}", FormatInfo(Extreme.Star));
+        }
+
+        std::println("");
+    };
+
+    std::println("Star statistics results:");
+    std::println("{}", FormatTitle());
+    std::println("");
+
+    PrintExtremes("Most luminous",   "luminosity", &FCategoryResult::MostLuminous);
+    PrintExtremes("Most massive",    "mass",       &FCategoryResult::MostMassive);
+    PrintExtremes("Largest",         "radius",     &FCategoryResult::Largest);
+    PrintExtremes("Hottest",         "Teff",       &FCategoryResult::Hottest);
+    PrintExtremes("Oldest",          "Age",        &FCategoryResult::Oldest);
+    PrintExtremes("Most oblateness", "Oblateness", &FCategoryResult::MostOblateness);
+
+    constexpr std::array<const char*, 7> kSpectralNames{ "O", "B", "A", "F", "G", "K", "M" };
+
+    const auto& MainSequence = Result[EStarCategory::kMainSequence];
+    std::size_t TotalMainSequence = std::accumulate(MainSequence.SpectralCounts.begin(), MainSequence.SpectralCounts.end(), static_cast<std::size_t>(0));
+    auto MainSequenceRate = [&](ESpectralIndex Index) -> double
+    {
+        return static_cast<double>(MainSequence.SpectralCounts[static_cast<std::size_t>(Index)]) / static_cast<double>(TotalMainSequence);
+    };
+
+    std::println("Total main sequence: {}", TotalMainSequence);
+    std::println("Total main sequence rate: {}", TotalMainSequence / static_cast<double>(Result.TotalStars));
+    for (std::size_t i = 0; i != kSpectralNames.size(); ++i)
+    {
+        std::println("Total {} type star rate: {}", kSpectralNames[i], MainSequenceRate(static_cast<ESpectralIndex>(i)));
+    }
+
+    std::println("Total Wolf-Rayet / O main star rate: {}",
+                 static_cast<double>(Result[EStarCategory::kWolfRayet].Count) /
+                 static_cast<double>(MainSequence.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeO)]));
+
+    constexpr std::array<std::pair<EStarCategory, const char*>, 6> kSpectralCategories
+    {
+        std::pair{ EStarCategory::kMainSequence, "main sequence" },
+        std::pair{ EStarCategory::kSubgiant,     "subgiants"     },
+        std::pair{ EStarCategory::kGiant,        "giants"        },
+        std::pair{ EStarCategory::kBrightGiant,  "bright giants" },
+        std::pair{ EStarCategory::kSupergiant,   "supergiants"   },
+        std::pair{ EStarCategory::kHypergiant,   "hypergiants"   }
+    };
+
+    for (const auto& [Category, Name] : kSpectralCategories)
+    {
+        for (std::size_t i = 0; i != kSpectralNames.size(); ++i)
+        {
+            std::println("{} type {}: {}", kSpectralNames[i], Name, Result[Category].SpectralCounts[i]);
+        }
+    }
+
+    std::println("Wolf-Rayet stars: {}", Result[EStarCategory::kWolfRayet].Count);
+    std::println("White dwarfs: {}\nNeutron stars: {}\nBlack holes: {}", Result.WhiteDwarfs, Result.NeutronStars, Result.BlackHoles);
+    std::println("");
+    std::println("Number of single stars: {}", Result.SingleStars);
+    std::println("Number of binary stars: {}", Result.BinaryStars);
+    std::println("");
+}
+
+void FStellarStatistics::Accumulate(const Astro::FStellarSystem&, const Astro::AStar& Star, FResult& Result)
+{
+    ++Result.TotalStars;
+
+    if (Star.GetIsSingleStar())
+    {
+        ++Result.SingleStars;
+    }
+    else
+    {
+        ++Result.BinaryStars;
+    }
+
+    const auto& Class = Star.GetStellarClass();
+    Astro::FStellarClass::EStellarType StellarType = Class.GetStellarType();
+    if (StellarType != Astro::FStellarClass::EStellarType::kNormalStar)
+    {
+        switch (StellarType)
+        {
+        case Astro::FStellarClass::EStellarType::kBlackHole:
+            ++Result.BlackHoles;
+            break;
+        case Astro::FStellarClass::EStellarType::kNeutronStar:
+            ++Result.NeutronStars;
+            break;
+        case Astro::FStellarClass::EStellarType::kWhiteDwarf:
+            ++Result.WhiteDwarfs;
+            break;
+        default:
+            break;
+        }
+
+        return;
+    }
+
+    Astro::FStellarClass::FSpectralType SpectralType = Class.Data();
+
+    EStarCategory Category = EStarCategory::kCount;
+    switch (SpectralType.LuminosityClass)
+    {
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_Unknown:
+        if (SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WC ||
+            SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WN ||
+            SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WO)
+        {
+            Category = EStarCategory::kWolfRayet;
+        }
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_0:
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_IaPlus:
+        Category = EStarCategory::kHypergiant;
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_Ia:
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_Iab:
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_Ib:
+        Category = EStarCategory::kSupergiant;
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_II:
+        Category = EStarCategory::kBrightGiant;
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_III:
+        Category = EStarCategory::kGiant;
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_IV:
+        Category = EStarCategory::kSubgiant;
+        break;
+    case Astro::FStellarClass::ELuminosityClass::kLuminosity_V:
+        Category = EStarCategory::kMainSequence;
+        break;
+    default:
+        break;
+    }
+
+    if (Category == EStarCategory::kCount)
+    {
+        return;
+    }
+
+    auto& CategoryResult = Result.Categories[static_cast<std::size_t>(Category)];
+    ++CategoryResult.Count;
+
+    // 沃尔夫-拉叶星不按光谱型计数
+    if (Category != EStarCategory::kWolfRayet)
+    {
+        switch (SpectralType.HSpectralClass)
+        {
+        case Astro::FStellarClass::ESpectralClass::kSpectral_O:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeO)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_B:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeB)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_A:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeA)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_F:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeF)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_G:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeG)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_K:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeK)];
+            break;
+        case Astro::FStellarClass::ESpectralClass::kSpectral_M:
+            ++CategoryResult.SpectralCounts[static_cast<std::size_t>(ESpectralIndex::kTypeM)];
+            break;
+        default:
+            break;
+        }
+    }
+
+    UpdateExtreme(Star.GetLuminosity() / kSolarLuminosity, &Star, CategoryResult.MostLuminous);
+    UpdateExtreme(Star.GetMass() / kSolarMass,             &Star, CategoryResult.MostMassive);
+    UpdateExtreme(Star.GetRadius() / kSolarRadius,         &Star, CategoryResult.Largest);
+    UpdateExtreme(Star.GetTeff(),                          &Star, CategoryResult.Hottest);
+    UpdateExtreme(Star.GetAge(),                           &Star, CategoryResult.Oldest);
+    UpdateExtreme(Star.GetOblateness(),                    &Star, CategoryResult.MostOblateness);
+}
+
+void FStellarStatistics::Merge(FResult& Result, const FResult& Other)
+{
+    Result.TotalStars   += Other.TotalStars;
+    Result.SingleStars  += Other.SingleStars;
+    Result.BinaryStars  += Other.BinaryStars;
+    Result.WhiteDwarfs  += Other.WhiteDwarfs;
+    Result.NeutronStars += Other.NeutronStars;
+    Result.BlackHoles   += Other.BlackHoles;
+
+    for (std::size_t i = 0; i != Result.Categories.size(); ++i)
+    {
+        auto& Category      = Result.Categories[i];
+        const auto& OtherCategory = Other.Categories[i];
+
+        Category.Count += OtherCategory.Count;
+        for (std::size_t j = 0; j != Category.SpectralCounts.size(); ++j)
+        {
+            Category.SpectralCounts[j] += OtherCategory.SpectralCounts[j];
+        }
+
+        MergeExtreme(Category.MostLuminous,   OtherCategory.MostLuminous);
+        MergeExtreme(Category.MostMassive,    OtherCategory.MostMassive);
+        MergeExtreme(Category.Largest,        OtherCategory.Largest);
+        MergeExtreme(Category.Hottest,        OtherCategory.Hottest);
+        MergeExtreme(Category.Oldest,         OtherCategory.Oldest);
+        MergeExtreme(Category.MostOblateness, OtherCategory.MostOblateness);
+    }
+
+    for (std::size_t i = 0; i != Result.Accumulators.size(); ++i)
+    {
+        Result.Accumulators[i]->Merge(*Other.Accumulators[i]);
+    }
+}
+
+void FStellarStatistics::Detach(FResult& Result)
+{
+    // 同一颗恒星可能是多个统计项的极值，只复制一次
+    std::unordered_map<const Astro::AStar*, const Astro::AStar*> Copies;
+    for (auto& Category : Result.Categories)
+    {
+        for (FExtremeStar* Extreme : { &Category.MostLuminous, &Category.MostMassive, &Category.Largest,
+                                       &Category.Hottest, &Category.Oldest, &Category.MostOblateness })
+        {
+            if (Extreme->Star == nullptr)
+            {
+                continue;
+            }
+
+            auto [it, bInserted] = Copies.try_emplace(Extreme->Star, nullptr);
+            if (bInserted)
+            {
+                Result.OwnedStars.push_back(std::make_unique<Astro::AStar>(*Extreme->Star));
+                it->second = Result.OwnedStars.back().get();
+            }
+
+            Extreme->Star = it->second;
+        }
+    }
+}
+
+_NPGS_END
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+#include "Engine/Core/Types/Entries/Astro/Star.h"
+#include "Engine/Core/Types/Entries/Astro/StellarSystem.h"
+
+_NPGS_BEGIN
+
+// 恒星统计引擎。按线程把恒星系统分成连续的区间做 map，各线程的局部结果按区间顺序 reduce，
+// 并列时保留排名靠前的恒星，因此结果与线程数无关，和串行统计一致
+class FStellarStatistics
+{
+public:
+    // 自定义统计项。每个线程从注册的原型克隆一份空的局部状态，统计完成后按区间顺序合并到第一份
+    class IAccumulator
+    {
+    public:
+        virtual ~IAccumulator() = default;
+
+        virtual std::unique_ptr<IAccumulator> Clone() const = 0;
+        virtual void Accumulate(const Astro::FStellarSystem& System, const Astro::AStar& Star) = 0;
+        virtual void Merge(const IAccumulator& Other) = 0;
+    };
+
+    enum class EStarCategory
+    {
+        kMainSequence,
+        kSubgiant,
+        kGiant,
+        kBrightGiant,
+        kSupergiant,
+        kHypergiant,
+        kWolfRayet,
+        kCount
+    };
+
+    // 光谱型 O, B, A, F, G, K, M 的下标
+    enum class ESpectralIndex
+    {
+        kTypeO,
+        kTypeB,
+        kTypeA,
+        kTypeF,
+        kTypeG,
+        kTypeK,
+        kTypeM,
+        kCount
+    };
+
+    struct FExtremeStar
+    {
+        double              Value{};
+        const Astro::AStar* Star{ nullptr };
+    };
+
+    struct FCategoryResult
+    {
+        std::array<std::size_t, static_cast<std::size_t>(ESpectralIndex::kCount)> SpectralCounts{};
+        std::size_t  Count{};
+        FExtremeStar MostLuminous;   // 单位 L_sun
+        FExtremeStar MostMassive;    // 单位 M_sun
+        FExtremeStar Largest;        // 单位 R_sun
+        FExtremeStar Hottest;        // 单位 K
+        FExtremeStar Oldest;         // 单位年
+        FExtremeStar MostOblateness;
+    };
+
+    struct FResult
+    {
+        std::array<FCategoryResult, static_cast<std::size_t>(EStarCategory::kCount)> Categories;
+
+        std::size_t TotalStars{};
+        std::size_t SingleStars{};
+        std::size_t BinaryStars{};
+        std::size_t WhiteDwarfs{};
+        std::size_t NeutronStars{};
+        std::size_t BlackHoles{};
+
+        std::vector<std::unique_ptr<IAccumulator>> Accumulators; // 与注册顺序一致
+        std::vector<std::unique_ptr<Astro::AStar>> OwnedStars;   // Detach 之后极值恒星的副本
+
+        const FCategoryResult& operator[](EStarCategory Category) const;
+    };
+
+public:
+    FStellarStatistics()  = default;
+    ~FStellarStatistics() = default;
+
+    std::size_t RegisterAccumulator(std::unique_ptr<IAccumulator>&& Prototype);
+    // 空的结果，每个注册的统计项各有一份空状态，可以作为多次统计合并的起点
+    FResult CreateResult() const;
+    FResult Compute(std::span<Astro::FStellarSystem> Systems, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const;
+    // 统计分散存放的恒星系统，例如按需生成时常驻内存的系统，结果按 Systems 的顺序合并
+    FResult Compute(std::span<Astro::FStellarSystem* const> Systems, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const;
+
+    static void Print(const FResult& Result);
+    // 把 Other 合并到 Result，Result 中的极值恒星可能指向 Other 中的恒星
+    static void Merge(FResult& Result, const FResult& Other);
+    // 复制极值恒星，使结果不再引用被统计的恒星系统，之后恒星系统可以销毁
+    static void Detach(FResult& Result);
+
+private:
+    template <typename Func>
+    FResult ComputeImpl(std::size_t SystemCount, Func&& GetSystem, Runtime::Thread::FThreadPool* ThreadPool, int MaxThread) const;
+
+    static void Accumulate(const Astro::FStellarSystem& System, const Astro::AStar& Star, FResult& Result);
+
+private:
+    std::vector<std::unique_ptr<IAccumulator>> _Prototypes;
+};
+
+_NPGS_END
@@ -0,0 +1,611 @@
+#include "ThreadValidation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "Engine/Core/Runtime/Threads/Parallel.h"
+#include "Engine/Core/Runtime/Threads/Task.h"
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+#include "Engine/Utils/Logger.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    using FThreadPool = Runtime::Thread::FThreadPool;
+    using ETaskLane   = FThreadPool::ETaskLane;
+
+    void Record(FThreadValidation::FCheckResult& Result, bool bMatched)
+    {
+        ++Result.CheckCount;
+        Result.MismatchCount += bMatched ? 0 : 1;
+    }
+
+    // 任务完成计数。在锁内递增和通知，Wait 返回后任务不会再访问它，调用方可以直接销毁
+    class FCompletionCounter
+    {
+    public:
+        void Increment()
+        {
+            std::lock_guard<std::mutex> Lock(_Mutex);
+            ++_Count;
+            _Condition.notify_all();
+        }
+
+        void Wait(std::size_t Expected)
+        {
+            std::unique_lock<std::mutex> Lock(_Mutex);
+            _Condition.wait(Lock, [this, Expected]() -> bool { return _Count >= Expected; });
+        }
+
+        std::size_t GetCount()
+        {
+            std::lock_guard<std::mutex> Lock(_Mutex);
+            return _Count;
+        }
+
+    private:
+        std::mutex              _Mutex;
+        std::condition_variable _Condition;
+        std::size_t             _Count{};
+    };
+
+    // 阻塞任务的闸门，Open 之前进入的任务都停在 Wait 中
+    class FGate
+    {
+    public:
+        void Wait()
+        {
+            std::unique_lock<std::mutex> Lock(_Mutex);
+            _Condition.wait(Lock, [this]() -> bool { return _bOpened; });
+        }
+
+        void Open()
+        {
+            std::lock_guard<std::mutex> Lock(_Mutex);
+            _bOpened = true;
+            _Condition.notify_all();
+        }
+
+    private:
+        std::mutex              _Mutex;
+        std::condition_variable _Condition;
+        bool                    _bOpened{ false };
+    };
+}
+
+// ThreadValidation implementations
+// --------------------------------
+FThreadValidation::FThreadValidation(const FValidationInfo& Info)
+    : _Info(Info)
+{
+}
+
+std::vector<FThreadValidation::FCheckResult> FThreadValidation::Run() const
+{
+    std::vector<FCheckResult> Results;
+
+    // 内存池的检查要求没有其他线程同时归还任务块，在线程池仍然空闲时最先进行
+    NpgsCoreInfo("Thread validation: checking task block reuse across threads...");
+    Results.push_back(CheckBlockPool());
+
+    NpgsCoreInfo("Thread validation: checking task submission and lanes...");
+    Results.push_back(CheckSubmit());
+    Results.push_back(CheckLanePriority());
+    Results.push_back(CheckWorkStealing());
+
+    NpgsCoreInfo("Thread validation: checking restart under concurrent submission...");
+    Results.push_back(CheckRestart());
+
+    NpgsCoreInfo("Thread validation: checking parallel loops and task graphs...");
+    Results.push_back(CheckParallelFor());
+    Results.push_back(CheckTaskGraph());
+
+    return Results;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckSubmit() const
+{
+    FCheckResult Result{ .Name = "Submit" };
+    auto* ThreadPool = FThreadPool::GetInstance();
+
+    // 每个通道的 future 都得到对应任务的返回值
+    std::vector<std::future<std::uint64_t>> Futures;
+    Futures.reserve(_Info.TaskCount);
+    for (std::uint64_t i = 0; i != _Info.TaskCount; ++i)
+    {
+        auto Lane = static_cast<ETaskLane>(i % static_cast<std::size_t>(ETaskLane::kCount));
+        Futures.push_back(ThreadPool->SubmitToLane(Lane, [i]() -> std::uint64_t { return i * i; }));
+    }
+
+    for (std::uint64_t i = 0; i != _Info.TaskCount; ++i)
+    {
+        Record(Result, Futures[i].get() == i * i);
+    }
+
+    auto Sum = ThreadPool->Submit([](std::uint64_t Lhs, std::uint64_t Rhs) -> std::uint64_t { return Lhs + Rhs; }, 2, 3);
+    Record(Result, Sum.get() == 5);
+
+    // 任务抛出的异常由 future 重新抛出
+    auto Failed = ThreadPool->Submit([]() -> int { throw std::runtime_error("Expected task failure."); });
+    try
+    {
+        Failed.get();
+        Record(Result, false);
+    }
+    catch (const std::runtime_error&)
+    {
+        Record(Result, true);
+    }
+
+    // Dispatch 的每个任务恰好执行一次
+    std::vector<std::atomic<std::uint32_t>> Executions(_Info.TaskCount);
+    FCompletionCounter Done;
+    for (std::size_t i = 0; i != _Info.TaskCount; ++i)
+    {
+        ThreadPool->Dispatch([&Executions, &Done, i]() -> void
+        {
+            Executions[i].fetch_add(1, std::memory_order_relaxed);
+            Done.Increment();
+        });
+    }
+
+    Done.Wait(_Info.TaskCount);
+    for (const auto& Execution : Executions)
+    {
+        Record(Result, Execution.load() == 1);
+    }
+
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckLanePriority() const
+{
+    FCheckResult Result{ .Name = "LanePriority" };
+    auto* ThreadPool  = FThreadPool::GetInstance();
+    int   WorkerCount = ThreadPool->GetMaxThreadCount();
+
+    // 先让每个工作线程阻塞在一个任务上，之后提交的任务全部留在队列中，打开闸门后由各线程按通道优先级领取
+    // 阻塞任务离开闸门后也计入完成数，等待全部完成后闸门才能销毁
+    FGate Gate;
+    FCompletionCounter Blocked;
+    FCompletionCounter Done;
+    for (int i = 0; i != WorkerCount; ++i)
+    {
+        ThreadPool->DispatchToLane(ETaskLane::kGeneration, [&Gate, &Blocked, &Done]() -> void
+        {
+            Blocked.Increment();
+            Gate.Wait();
+            Done.Increment();
+        });
+    }
+
+    Blocked.Wait(WorkerCount);
+
+    // 先提交生成任务，后提交交互任务，记录每个任务开始的次序
+    std::size_t TaskCount = _Info.TaskCount;
+    std::vector<std::size_t> GenerationOrders(TaskCount);
+    std::vector<std::size_t> InteractiveOrders(TaskCount);
+    std::atomic<std::size_t> NextOrder{ 0 };
+    for (auto* Orders : { &GenerationOrders, &InteractiveOrders })
+    {
+        ETaskLane Lane = Orders == &GenerationOrders ? ETaskLane::kGeneration : ETaskLane::kInteractive;
+        for (std::size_t i = 0; i != TaskCount; ++i)
+        {
+            ThreadPool->DispatchToLane(Lane, [Orders, &NextOrder, &Done, i]() -> void
+            {
+                (*Orders)[i] = NextOrder.fetch_add(1);
+                Done.Increment();
+            });
+        }
+    }
+
+    Gate.Open();
+    Done.Wait(2 * TaskCount + WorkerCount);
+
+    // 工作线程先取完自己的交互任务，再窃取其他线程的交互任务，窃取时遇到被占用的队列会跳过，
+    // 因此允许最后阶段每个线程提前开始少量生成任务，但绝大多数生成任务必须排在全部交互任务之后
+    std::size_t LastInteractive = TaskCount != 0 ? std::ranges::max(InteractiveOrders) : 0;
+    auto EarlyGenerationCount = static_cast<std::size_t>(std::ranges::count_if(GenerationOrders,
+    [LastInteractive](std::size_t Order) -> bool
+    {
+        return Order < LastInteractive;
+    }));
+
+    Record(Result, EarlyGenerationCount <= static_cast<std::size_t>(WorkerCount - 1) * 4);
+    Record(Result, WorkerCount > 1 || EarlyGenerationCount == 0);
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckWorkStealing() const
+{
+    constexpr std::size_t kNestedTaskCount = 256;
+
+    FCheckResult Result{ .Name = "WorkStealing" };
+    auto* ThreadPool = FThreadPool::GetInstance();
+
+    // 只有一个工作线程时没有可以窃取的队列
+    if (ThreadPool->GetMaxThreadCount() == 1)
+    {
+        return Result;
+    }
+
+    bool bTelemetryEnabled = ThreadPool->IsTelemetryEnabled();
+    ThreadPool->ResetTelemetry();
+    ThreadPool->SetTelemetryEnabled(true);
+
+    // 工作线程内提交的任务进入它自己的队列，其他线程空闲时必须把它们窃取过去
+    std::mutex ThreadIdMutex;
+    std::set<std::thread::id> ThreadIds;
+    FCompletionCounter Done;
+    auto Outer = ThreadPool->Submit([&]() -> void
+    {
+        for (std::size_t i = 0; i != kNestedTaskCount; ++i)
+        {
+            ThreadPool->Dispatch([&]() -> void
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                {
+                    std::lock_guard<std::mutex> Lock(ThreadIdMutex);
+                    ThreadIds.insert(std::this_thread::get_id());
+                }
+
+                Done.Increment();
+            });
+        }
+    });
+
+    Outer.get();
+    Done.Wait(kNestedTaskCount);
+
+    std::uint64_t StealCount = 0;
+    for (const auto& Worker : ThreadPool->GetTelemetry())
+    {
+        StealCount += Worker.StealCount;
+    }
+
+    Record(Result, ThreadIds.size() > 1);
+    Record(Result, StealCount > 0);
+
+    ThreadPool->SetTelemetryEnabled(bTelemetryEnabled);
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckRestart() const
+{
+    FCheckResult Result{ .Name = "Restart" };
+    auto* ThreadPool  = FThreadPool::GetInstance();
+    int   WorkerCount = ThreadPool->GetMaxThreadCount();
+
+    // Terminate 之后提交任务会自动重新启动线程池
+    ThreadPool->Terminate();
+    Record(Result, !ThreadPool->IsRunning());
+    auto Future = ThreadPool->Submit([]() -> int { return 42; });
+    Record(Result, Future.get() == 42);
+    Record(Result, ThreadPool->IsRunning());
+
+    // 放置方式不变时线程数不变，线程池继续可用
+    ThreadPool->SetThreadPlacement(true);
+    Record(Result, ThreadPool->GetMaxThreadCount() == WorkerCount);
+    Record(Result, ThreadPool->Submit([]() -> int { return 7; }).get() == 7);
+
+    // 外部线程持续提交，同时反复结束和启动线程池。Terminate 执行完已提交的任务才返回，最后结束一次后计数必须等于任务数
+    FCompletionCounter Done;
+    std::thread Submitter([&]() -> void
+    {
+        for (std::size_t i = 0; i != _Info.TaskCount; ++i)
+        {
+            ThreadPool->Dispatch([&Done]() -> void { Done.Increment(); });
+        }
+    });
+
+    for (std::size_t i = 0; i != _Info.RestartCount; ++i)
+    {
+        ThreadPool->Terminate();
+        ThreadPool->Start();
+    }
+
+    Submitter.join();
+    ThreadPool->Terminate();
+    Record(Result, Done.GetCount() == _Info.TaskCount);
+    ThreadPool->Start();
+    Record(Result, ThreadPool->IsRunning());
+
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckBlockPool() const
+{
+    using FTaskBlockPool = Runtime::Thread::FTaskBlockPool;
+
+    FCheckResult Result{ .Name = "TaskBlockPool" };
+    constexpr std::size_t kBlockSize  = FTaskBlockPool::kBlockGranularity;
+    constexpr std::size_t kBlockCount = 2 * FTaskBlockPool::kMaxCachedBlocks;
+
+    // 分配、释放和再次分配分别在三个新线程上进行，每个线程的缓存开始时都是空的
+    // 释放线程的缓存溢出和线程结束时把块交给中心缓存，之后新线程分配到的必须正是这些块，而不是新的堆内存
+    std::vector<void*> Blocks(kBlockCount);
+    std::thread([&Blocks]() -> void
+    {
+        for (auto& Block : Blocks)
+        {
+            Block = FTaskBlockPool::Allocate(kBlockSize);
+        }
+    }).join();
+
+    std::thread([&Blocks]() -> void
+    {
+        for (void* Block : Blocks)
+        {
+            FTaskBlockPool::Deallocate(Block, kBlockSize);
+        }
+    }).join();
+
+    std::vector<void*> ReusedBlocks(kBlockCount);
+    std::thread([&ReusedBlocks]() -> void
+    {
+        for (auto& Block : ReusedBlocks)
+        {
+            Block = FTaskBlockPool::Allocate(kBlockSize);
+        }
+    }).join();
+
+    std::ranges::sort(Blocks);
+    for (void* Block : ReusedBlocks)
+    {
+        Record(Result, std::ranges::binary_search(Blocks, Block));
+    }
+
+    std::thread([&ReusedBlocks]() -> void
+    {
+        for (void* Block : ReusedBlocks)
+        {
+            FTaskBlockPool::Deallocate(Block, kBlockSize);
+        }
+    }).join();
+
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckParallelFor() const
+{
+    FCheckResult Result{ .Name = "ParallelFor" };
+    auto* ThreadPool = FThreadPool::GetInstance();
+
+    // 线程数多于工作线程数，多出来的部分由调用线程和已经空闲的线程承担
+    int         MaxThread = ThreadPool->GetMaxThreadCount() + 2;
+    std::size_t Count     = _Info.TaskCount * 16;
+
+    // 每个元素恰好访问一次，ThreadId 在范围内，同一个 ThreadId 的调用不会并发
+    for (std::size_t MinChunkSize : { 1, 7, 64 })
+    {
+        std::vector<std::atomic<std::uint32_t>> Visits(Count);
+        std::vector<std::atomic<bool>> bBusy(MaxThread);
+        std::atomic<bool> bConflicted{ false };
+        Runtime::Thread::ParallelFor(ThreadPool, MaxThread, Count, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+        {
+            if (ThreadId < 0 || ThreadId >= MaxThread || bBusy[ThreadId].exchange(true))
+            {
+                bConflicted = true;
+                return;
+            }
+
+            for (std::size_t i = Begin; i != End; ++i)
+            {
+                Visits[i].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            bBusy[ThreadId].store(false);
+        }, MinChunkSize);
+
+        Record(Result, !bConflicted);
+        Record(Result, std::ranges::all_of(Visits, [](const auto& Visit) -> bool { return Visit.load() == 1; }));
+    }
+
+    // 嵌套的 ParallelFor 不会死锁，结果完整
+    constexpr std::size_t kInnerCount = 1000;
+    std::atomic<std::uint64_t> NestedSum{ 0 };
+    Runtime::Thread::ParallelFor(ThreadPool, MaxThread, 64, [&](int, std::size_t Begin, std::size_t End) -> void
+    {
+        for (std::size_t i = Begin; i != End; ++i)
+        {
+            Runtime::Thread::ParallelFor(ThreadPool, MaxThread, kInnerCount, [&](int, std::size_t InnerBegin, std::size_t InnerEnd) -> void
+            {
+                std::uint64_t Sum = 0;
+                for (std::size_t j = InnerBegin; j != InnerEnd; ++j)
+                {
+                    Sum += j;
+                }
+
+                NestedSum.fetch_add(Sum);
+            });
+        }
+    });
+
+    Record(Result, NestedSum.load() == 64 * (kInnerCount * (kInnerCount - 1) / 2));
+
+    // 抛出的异常在调用线程重新抛出，返回时没有仍在执行的区间，之后也不会再开始新的区间
+    std::atomic<int> InFlightCount{ 0 };
+    std::atomic<std::size_t> CallCount{ 0 };
+    bool bThrown = false;
+    int InFlightAtReturn = -1;
+    std::size_t CallsAtReturn = 0;
+    try
+    {
+        Runtime::Thread::ParallelFor(ThreadPool, MaxThread, Count, [&](int, std::size_t Begin, std::size_t End) -> void
+        {
+            InFlightCount.fetch_add(1);
+            CallCount.fetch_add(1);
+            bool bFailing = Begin <= Count / 2 && Count / 2 < End;
+            InFlightCount.fetch_sub(1);
+            if (bFailing)
+            {
+                throw std::runtime_error("Expected loop failure.");
+            }
+        }, 16);
+    }
+    catch (const std::runtime_error&)
+    {
+        bThrown          = true;
+        InFlightAtReturn = InFlightCount.load();
+        CallsAtReturn    = CallCount.load();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Record(Result, bThrown);
+    Record(Result, InFlightAtReturn == 0);
+    Record(Result, CallCount.load() == CallsAtReturn);
+
+    // 归约的结果与串行求和相同
+    std::uint64_t Sum = Runtime::Thread::ParallelReduce(ThreadPool, MaxThread, Count, static_cast<std::uint64_t>(0),
+    [](std::uint64_t& Local, std::size_t Begin, std::size_t End) -> void
+    {
+        for (std::size_t i = Begin; i != End; ++i)
+        {
+            Local += i;
+        }
+    },
+    [](std::uint64_t Lhs, std::uint64_t Rhs) -> std::uint64_t
+    {
+        return Lhs + Rhs;
+    }, 16);
+
+    Record(Result, Sum == static_cast<std::uint64_t>(Count) * (Count - 1) / 2);
+
+    // 固定区间按序号首尾相接，覆盖 [0, Count)，每个区间恰好调用一次
+    std::vector<std::pair<std::size_t, std::size_t>> Ranges(MaxThread);
+    std::vector<std::atomic<std::uint32_t>> RangeCalls(MaxThread);
+    Runtime::Thread::ForEachThreadRange(ThreadPool, MaxThread, Count, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+    {
+        Ranges[ThreadId] = { Begin, End };
+        RangeCalls[ThreadId].fetch_add(1);
+    });
+
+    bool bContiguous = Ranges.front().first == 0 && Ranges.back().second == Count;
+    for (int i = 0; i != MaxThread; ++i)
+    {
+        bContiguous = bContiguous && RangeCalls[i].load() == 1 && (i == 0 || Ranges[i - 1].second == Ranges[i].first);
+    }
+
+    Record(Result, bContiguous);
+    return Result;
+}
+
+FThreadValidation::FCheckResult FThreadValidation::CheckTaskGraph() const
+{
+    using FTaskGraph = Runtime::Thread::FTaskGraph;
+
+    constexpr std::size_t kNodeCount  = 64;
+    constexpr int         kGraphCount = 16;
+
+    FCheckResult Result{ .Name = "TaskGraph" };
+    auto* ThreadPool = FThreadPool::GetInstance();
+    std::mt19937 RandomEngine(_Info.Seed);
+    std::bernoulli_distribution EdgeDistribution(0.1);
+
+    // 随机的有向无环图：每个任务开始时它的前驱都已经完成，每个任务恰好执行一次
+    for (int Graph = 0; Graph != kGraphCount; ++Graph)
+    {
+        FTaskGraph TaskGraph;
+        std::vector<std::vector<FTaskGraph::FTaskId>> Predecessors(kNodeCount);
+        std::vector<std::atomic<std::uint32_t>> Executions(kNodeCount);
+        std::atomic<bool> bOrderViolated{ false };
+
+        for (std::size_t Node = 0; Node != kNodeCount; ++Node)
+        {
+            TaskGraph.AddTask([&, Node]() -> void
+            {
+                for (auto Predecessor : Predecessors[Node])
+                {
+                    if (Executions[Predecessor].load() != 1)
+                    {
+                        bOrderViolated = true;
+                    }
+                }
+
+                Executions[Node].fetch_add(1);
+            });
+        }
+
+        for (std::size_t Successor = 0; Successor != kNodeCount; ++Successor)
+        {
+            for (std::size_t Predecessor = 0; Predecessor != Successor; ++Predecessor)
+            {
+                if (EdgeDistribution(RandomEngine))
+                {
+                    TaskGraph.AddDependency(Predecessor, Successor);
+                    Predecessors[Successor].push_back(Predecessor);
+                }
+            }
+        }
+
+        TaskGraph.Execute(ThreadPool);
+        Record(Result, !bOrderViolated);
+        Record(Result, std::ranges::all_of(Executions, [](const auto& Execution) -> bool { return Execution.load() == 1; }));
+    }
+
+    // 任务抛出的异常在 Execute 中重新抛出，依赖它的任务不再执行
+    {
+        FTaskGraph TaskGraph;
+        std::atomic<bool> bSuccessorRan{ false };
+        auto Failing   = TaskGraph.AddTask([]() -> void { throw std::runtime_error("Expected graph failure."); });
+        auto Successor = TaskGraph.AddTask([&bSuccessorRan]() -> void { bSuccessorRan = true; });
+        TaskGraph.AddDependency(Failing, Successor);
+
+        try
+        {
+            TaskGraph.Execute(ThreadPool);
+            Record(Result, false);
+        }
+        catch (const std::runtime_error&)
+        {
+            Record(Result, !bSuccessorRan);
+        }
+    }
+
+    // 有环的图在执行任何任务之前被拒绝，越界的依赖直接拒绝
+    {
+        FTaskGraph TaskGraph;
+        std::atomic<int> RunCount{ 0 };
+        auto First  = TaskGraph.AddTask([&RunCount]() -> void { ++RunCount; });
+        auto Second = TaskGraph.AddTask([&RunCount]() -> void { ++RunCount; });
+        TaskGraph.AddTask([&RunCount]() -> void { ++RunCount; });
+        TaskGraph.AddDependency(First, Second);
+        TaskGraph.AddDependency(Second, First);
+
+        try
+        {
+            TaskGraph.Execute(ThreadPool);
+            Record(Result, false);
+        }
+        catch (const std::logic_error&)
+        {
+            Record(Result, RunCount.load() == 0);
+        }
+
+        try
+        {
+            TaskGraph.AddDependency(First, kNodeCount);
+            Record(Result, false);
+        }
+        catch (const std::out_of_range&)
+        {
+            Record(Result, true);
+        }
+    }
+
+    return Result;
+}
+
+_NPGS_END
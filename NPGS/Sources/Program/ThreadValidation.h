@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+
+// 检查线程池、任务内存池、并行循环和任务依赖图的行为，结果与预期的计数、顺序或异常比较
+// 不依赖窗口和星表数据，可以在命令行中运行。运行期间会反复结束和启动全局线程池，不能与其他使用线程池的工作同时进行
+class FThreadValidation
+{
+public:
+    struct FValidationInfo
+    {
+        std::uint32_t Seed{};
+        std::size_t   TaskCount{};    // 每项检查提交的任务数
+        std::size_t   RestartCount{}; // 并发提交时结束并重新启动线程池的次数
+    };
+
+    struct FCheckResult
+    {
+        std::string Name;
+        std::size_t CheckCount{};    // 比较的次数
+        std::size_t MismatchCount{}; // 与预期不一致的次数
+    };
+
+public:
+    explicit FThreadValidation(const FValidationInfo& Info);
+    ~FThreadValidation() = default;
+
+    std::vector<FCheckResult> Run() const;
+
+private:
+    FCheckResult CheckSubmit() const;
+    FCheckResult CheckLanePriority() const;
+    FCheckResult CheckWorkStealing() const;
+    FCheckResult CheckRestart() const;
+    FCheckResult CheckBlockPool() const;
+    FCheckResult CheckParallelFor() const;
+    FCheckResult CheckTaskGraph() const;
+
+private:
+    FValidationInfo _Info;
+};
+
+_NPGS_END
@@ -3,25 +3,206 @@
 #include <cstdlib>
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <deque>
 #include <format>
-#include <iomanip>
 #include <iterator>
 #include <limits>
-#include <print>
+#include <numeric>
 #include <ranges>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <utility>
 
 #include "Engine/Core/Base/Base.h"
 #include "Engine/Core/Math/NumericConstants.h"
-#include "Engine/Core/System/Generators/OrbitalGenerator.h"
+#include "Engine/Core/Runtime/Threads/Parallel.h"
 #include "Engine/Utils/Logger.h"
 
 _NPGS_BEGIN
 
 namespace SysGen = Npgs::System::Generator;
 
+// Tool functions
+// --------------
+namespace
+{
+    // 由格子种子、距离排名和步骤编号组成种子序列，排名保证不同格子的随机数流互不相同
+    std::seed_seq MakeSlotSeedSequence(std::uint32_t Seed, std::size_t DistanceRank, std::uint32_t Stream)
+    {
+        return std::seed_seq
+        {
+            Seed,
+            static_cast<std::uint32_t>(DistanceRank),
+            static_cast<std::uint32_t>(static_cast<std::uint64_t>(DistanceRank) >> 32),
+            Stream
+        };
+    }
+
+    // 并行 LSD 基数排序，每趟处理 8 位。各线程先统计自己区间的直方图，再按 (桶, 线程) 的顺序计算写入位置并分散，
+    // 因此排序是稳定的，结果与线程数无关。Indices 随键一起移动
+    void ParallelRadixSort(Runtime::Thread::FThreadPool* ThreadPool, int MaxThread,
+                           std::vector<std::uint32_t>& Keys, std::vector<std::size_t>& Indices)
+    {
+        constexpr int kRadixBits  = 8;
+        constexpr int kRadixCount = 1 << kRadixBits;
+
+        std::size_t Count = Keys.size();
+        std::vector<std::uint32_t> SwapKeys(Count);
+        std::vector<std::size_t>   SwapIndices(Count);
+        std::vector<std::array<std::size_t, kRadixCount>> Offsets(MaxThread);
+
+        for (int Shift = 0; Shift != 32; Shift += kRadixBits)
+        {
+            Runtime::Thread::ForEachThreadRange(ThreadPool, MaxThread, Count, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+            {
+                auto& Histogram = Offsets[ThreadId];
+                Histogram.fill(0);
+                for (std::size_t i = Begin; i != End; ++i)
+                {
+                    ++Histogram[(Keys[i] >> Shift) & (kRadixCount - 1)];
+                }
+            });
+
+            bool bSingleBucket = false;
+            std::size_t Position = 0;
+            for (int Radix = 0; Radix != kRadixCount; ++Radix)
+            {
+                std::size_t BucketBegin = Position;
+                for (auto& Histogram : Offsets)
+                {
+                    std::size_t BucketSize = Histogram[Radix];
+                    Histogram[Radix] = Position;
+                    Position += BucketSize;
+                }
+
+                bSingleBucket |= Position - BucketBegin == Count;
+            }
+
+            // 所有键在这一趟的位都相同，顺序不会改变
+            if (bSingleBucket)
+            {
+                continue;
+            }
+
+            Runtime::Thread::ForEachThreadRange(ThreadPool, MaxThread, Count, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+            {
+                auto& Offset = Offsets[ThreadId];
+                for (std::size_t i = Begin; i != End; ++i)
+                {
+                    std::size_t Target   = Offset[(Keys[i] >> Shift) & (kRadixCount - 1)]++;
+                    SwapKeys[Target]    = Keys[i];
+                    SwapIndices[Target] = Indices[i];
+                }
+            });
+
+            Keys.swap(SwapKeys);
+            Indices.swap(SwapIndices);
+        }
+    }
+
+    // 直方图中累计比例达到 Quantile 的桶的上界，单位微秒
+    std::uint64_t GetHistogramQuantile(const std::array<std::uint64_t, Runtime::Thread::FThreadPool::kHistogramBucketCount>& Histogram,
+                                       double Quantile)
+    {
+        std::uint64_t TotalCount = std::accumulate(Histogram.begin(), Histogram.end(), static_cast<std::uint64_t>(0));
+        std::uint64_t Threshold  = static_cast<std::uint64_t>(std::ceil(TotalCount * Quantile));
+        std::uint64_t Count      = 0;
+        for (std::size_t Bucket = 0; Bucket != Histogram.size(); ++Bucket)
+        {
+            Count += Histogram[Bucket];
+            if (Count >= Threshold)
+            {
+                return static_cast<std::uint64_t>(1) << Bucket;
+            }
+        }
+
+        return static_cast<std::uint64_t>(1) << (Histogram.size() - 1);
+    }
+
+    void LogThreadPoolTelemetry(const Runtime::Thread::FThreadPool* ThreadPool)
+    {
+        auto Telemetry = ThreadPool->GetTelemetry();
+        for (std::size_t i = 0; i != Telemetry.size(); ++i)
+        {
+            const auto& Worker = Telemetry[i];
+            double BusyMilliseconds = Worker.BusyNanoseconds * 1e-6;
+            double IdleMilliseconds = Worker.IdleNanoseconds * 1e-6;
+            double TotalMilliseconds = BusyMilliseconds + IdleMilliseconds;
+            double Utilization = TotalMilliseconds > 0.0 ? BusyMilliseconds / TotalMilliseconds * 100.0 : 0.0;
+
+            NpgsCoreInfo("Worker {}: {} tasks, {} steals, busy {:.1f} ms, idle {:.1f} ms ({:.1f}% busy), "
+                         "queue wait p50/p99 < {}/{} us, run time p50/p99 < {}/{} us.",
+                         i, Worker.TaskCount, Worker.StealCount, BusyMilliseconds, IdleMilliseconds, Utilization,
+                         GetHistogramQuantile(Worker.QueueWaitHistogram, 0.5), GetHistogramQuantile(Worker.QueueWaitHistogram, 0.99),
+                         GetHistogramQuantile(Worker.RunTimeHistogram, 0.5), GetHistogramQuantile(Worker.RunTimeHistogram, 0.99));
+        }
+    }
+}
+
+// Universe implementations
+// ------------------------
+FUniverse::FSystemGenerators::FSystemGenerators(const std::seed_seq& SeedSequence, float UniverseAge)
+    :
+    CompanionGenerator(SeedSequence, SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
+                       SysGen::FStellarGenerator::EMultiplicityGenerationOption::kBinarySecondStar),
+    OrbitalGenerator(SeedSequence)
+{
+    auto CreateGenerator =
+    [&](SysGen::FStellarGenerator::EStellarTypeGenerationOption StellarTypeOption =
+        SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
+        float MassLowerLimit = 0.1f,  float MassUpperLimit = 300.0f,
+        SysGen::FStellarGenerator::EGenerationDistribution MassDistribution =
+        SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
+        float AgeLowerLimit  = 0.0f,  float AgeUpperLimit  = 1.26e10f,
+        SysGen::FStellarGenerator::EGenerationDistribution AgeDistribution  =
+        SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
+        float FeHLowerLimit  = -4.0f, float FeHUpperLimit  = 0.5f,
+        SysGen::FStellarGenerator::EGenerationDistribution FeHDistribution  =
+        SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf) -> void
+    {
+        SysGen::FStellarGenerator::FStellarGenerationInfo GenerationInfo
+        {
+            .SeedSequence       = &SeedSequence,
+            .StellarTypeOption  = StellarTypeOption,
+            .MultiplicityOption = SysGen::FStellarGenerator::EMultiplicityGenerationOption::kSingleStar,
+            .UniverseAge        = UniverseAge,
+            .MassLowerLimit     = MassLowerLimit,
+            .MassUpperLimit     = MassUpperLimit,
+            .MassDistribution   = MassDistribution,
+            .AgeLowerLimit      = AgeLowerLimit,
+            .AgeUpperLimit      = AgeUpperLimit,
+            .AgeDistribution    = AgeDistribution,
+            .FeHLowerLimit      = FeHLowerLimit,
+            .FeHUpperLimit      = FeHUpperLimit,
+            .FeHDistribution    = FeHDistribution
+        };
+
+        StellarGenerators.push_back(GenerationInfo);
+    };
+
+    // 创建顺序与 EStellarSlotType 一致，普通恒星的生成器同时用于插值所有恒星数据
+    StellarGenerators.reserve(_kStellarSlotTypeCount);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom, 0.075f);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kGiant, 1.0f, 35.0f);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
+                    20.0f, 300.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
+                    0.0f,  3.5e6f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kDeathStar,
+                    10.0f, 20.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
+                    1e7f,  1e8f,  SysGen::FStellarGenerator::EGenerationDistribution::kUniformByExponent);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
+                    35.0f,  300.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
+                    1e7f, 1.26e10f, SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
+                    -2.0, 0.5);
+    CreateGenerator(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kMergeStar,
+                    0.0f, 0.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
+                    1e6f, 1e8f, SysGen::FStellarGenerator::EGenerationDistribution::kUniformByExponent);
+}
+
 FUniverse::FUniverse(std::uint32_t Seed, std::size_t StarCount, std::size_t ExtraGiantCount, std::size_t ExtraMassiveStarCount,
                      std::size_t ExtraNeutronStarCount, std::size_t ExtraBlackHoleCount, std::size_t ExtraMergeStarCount,
                      float UniverseAge)
@@ -30,6 +211,10 @@ FUniverse::FUniverse(std::uint32_t Seed, std::size_t StarCount, std::size_t Extr
     _SeedGenerator(0ull, std::numeric_limits<std::uint32_t>::max()),
     _CommonGenerator(0.0f, 1.0f),
     _ThreadPool(Runtime::Thread::FThreadPool::GetInstance()),
+    _ReadySystemCount(0),
+    _GenerationFocus(0.0f),
+    _bPrepared(false),
+    _bOnDemand(false),
 
     _StarCount(StarCount),
     _ExtraGiantCount(ExtraGiantCount),
@@ -48,800 +233,630 @@ FUniverse::FUniverse(std::uint32_t Seed, std::size_t StarCount, std::size_t Extr
     std::shuffle(Seeds.begin(), Seeds.end(), _RandomEngine);
     std::seed_seq SeedSequence(Seeds.begin(), Seeds.end());
     _RandomEngine.seed(SeedSequence);
+    _InitialRandomEngine = _RandomEngine;
+}
+
+FUniverse::~FUniverse()
+{
+    // 析构时不能抛出，后台生成中的异常直接丢弃
+    if (_GenerationThread.joinable())
+    {
+        _GenerationThread.join();
+    }
 }
 
 void FUniverse::FillUniverse()
 {
     int MaxThread = _ThreadPool->GetMaxThreadCount();
 
-    GenerateStars(MaxThread);
-    FillStellarSystem(MaxThread);
+    WaitForCompletion();
 
-    _ThreadPool->Terminate();
+    // 上次生成被取消时，已经完成的恒星系统保留，从完成的前缀继续
+    if (!CanResumeGeneration(glm::vec3(0.0f)))
+    {
+        PrepareStellarSystems(MaxThread, glm::vec3(0.0f));
+    }
+
+    GenerateStellarSystems(MaxThread, GetReadySystemCount(), _GenerationOrder.size());
+
+    _SystemGenerators.clear();
+    _bPrepared = false;
+    UpdateOctreeAggregates();
+    BeginGenerationPhase(FGenerationToken::EPhase::kCompleted, _GenerationOrder.size());
+
+    if (_ThreadPool->IsTelemetryEnabled())
+    {
+        LogThreadPoolTelemetry(_ThreadPool);
+    }
 }
 
-void FUniverse::ReplaceStar(std::size_t DistanceRank, const Astro::AStar& StarData)
+void FUniverse::FillUniverseProgressive(std::size_t NearFieldSystemCount, const glm::vec3& FocusPosition)
 {
-    for (auto& System : _StellarSystems)
+    int MaxThread = _ThreadPool->GetMaxThreadCount();
+
+    WaitForCompletion();
+    if (!CanResumeGeneration(FocusPosition))
+    {
+        PrepareStellarSystems(MaxThread, FocusPosition);
+    }
+
+    // 先同步生成焦点附近的恒星系统，返回时这些系统已经可用
+    std::size_t SystemCount  = _GenerationOrder.size();
+    std::size_t ReadyCount   = GetReadySystemCount();
+    std::size_t NearFieldEnd = std::min(std::max(NearFieldSystemCount, static_cast<std::size_t>(1)), SystemCount);
+    NearFieldEnd = std::max(NearFieldEnd, ReadyCount);
+    GenerateStellarSystems(MaxThread, ReadyCount, NearFieldEnd);
+    NpgsCoreInfo("Near field stellar systems ready: {} of {}.", NearFieldEnd, SystemCount);
+
+    // 剩余部分在后台按距离由近到远分批生成，批次大小逐次翻倍，兼顾发布延迟和并行效率
+    // 后台线程中的取消不会抛出到调用方，已完成的前缀保留，之后可以继续
+    // 其他异常保存下来，由 WaitForCompletion 在调用方线程重新抛出
+    // 后台线程只写入恒星系统和就绪计数，生成器和准备状态由汇合的线程在 WaitForCompletion 中清理
+    _GenerationThread = std::thread([this, MaxThread, NearFieldEnd, SystemCount]() -> void
     {
-        if (DistanceRank == System.GetBaryDistanceRank())
+        constexpr std::size_t kMaxBatchSize = 1 << 18;
+
+        try
         {
-            auto& Stars = System.StarsData();
-            if (Stars.size() > 1)
+            std::size_t BeginIndex = NearFieldEnd;
+            while (BeginIndex != SystemCount)
             {
-                return; // TODO: 处理双星
+                std::size_t BatchSize = std::min(std::max(BeginIndex, NearFieldEnd), kMaxBatchSize);
+                std::size_t EndIndex  = std::min(BeginIndex + BatchSize, SystemCount);
+                GenerateStellarSystems(MaxThread, BeginIndex, EndIndex);
+                BeginIndex = EndIndex;
             }
-
-            Stars.clear();
-            Stars.push_back(std::make_unique<Astro::AStar>(StarData));
         }
-    }
+        catch (const FGenerationCancelled&)
+        {
+            NpgsCoreInfo("Background stellar generation cancelled: {} of {} systems ready.", GetReadySystemCount(), SystemCount);
+            return;
+        }
+        catch (...)
+        {
+            _GenerationException = std::current_exception();
+            return;
+        }
+
+        BeginGenerationPhase(FGenerationToken::EPhase::kCompleted, SystemCount);
+
+        NpgsCoreInfo("Background stellar generation completed.");
+    });
 }
 
-void FUniverse::CountStars()
+void FUniverse::FillUniverseOnDemand()
 {
-    constexpr int kTypeOIndex = 0;
-    constexpr int kTypeBIndex = 1;
-    constexpr int kTypeAIndex = 2;
-    constexpr int kTypeFIndex = 3;
-    constexpr int kTypeGIndex = 4;
-    constexpr int kTypeKIndex = 5;
-    constexpr int kTypeMIndex = 6;
-
-    std::array<std::size_t, 7> MainSequence{};
-    std::array<std::size_t, 7> Subgiants{};
-    std::array<std::size_t, 7> Giants{};
-    std::array<std::size_t, 7> BrightGiants{};
-    std::array<std::size_t, 7> Supergiants{};
-    std::array<std::size_t, 7> Hypergiants{};
-
-    std::size_t WolfRayet    = 0;
-    std::size_t WhiteDwarfs  = 0;
-    std::size_t NeutronStars = 0;
-    std::size_t BlackHoles   = 0;
-    std::size_t TotalStars   = 1;
-    std::size_t TotalBinarys = 0;
-    std::size_t TotalSingles = 0;
-
-    struct MostLuminous
-    {
-        double LuminositySol{};
-        const Astro::AStar* Star = nullptr;
-    };
+    WaitForCompletion();
 
-    struct MostMassive
-    {
-        double MassSol{};
-        const Astro::AStar* Star = nullptr;
-    };
+    NpgsCoreInfo("Building stellar octree in 8 threads...");
+    GenerateSlots(0.1f, _StarCount, 0.004f);
+
+    NpgsCoreInfo("Assigning seeds to stellar slots...");
+    CollectStellarSlots(_ThreadPool->GetMaxThreadCount());
+
+    // 按需模式下只保留格子，八叉树中的位置点不链接恒星系统
+    _StellarSystems.clear();
+    _StellarSystems.shrink_to_fit();
+    _GenerationOrder.clear();
+    _GenerationIndices.clear();
+    _ReadySystemCount.store(0, std::memory_order_release);
+
+    std::scoped_lock Lock(_MaterializationMutex);
+    _MaterializedSystems.clear();
+    CreateSystemGenerators(1);
+    _bPrepared = false;
+    _bOnDemand = true;
+
+    NpgsCoreInfo("Stellar slots ready: {} systems will be generated on demand.", _StellarSlots.size());
+}
 
-    struct Largest
+void FUniverse::WaitForCompletion()
+{
+    if (!_GenerationThread.joinable())
     {
-        float RadiusSol{};
-        const Astro::AStar* Star = nullptr;
-    };
+        return;
+    }
+
+    _GenerationThread.join();
 
-    struct Hottest
+    // 生成失败时生成器的状态不确定，丢弃准备结果，下次生成重新准备
+    if (_GenerationException != nullptr)
     {
-        float Teff{};
-        const Astro::AStar* Star = nullptr;
-    };
+        _SystemGenerators.clear();
+        _bPrepared = false;
+        std::rethrow_exception(std::exchange(_GenerationException, nullptr));
+    }
 
-    struct Oldest
+    if (_bPrepared && GetReadySystemCount() == _GenerationOrder.size())
     {
-        double Age{};
-        const Astro::AStar* Star = nullptr;
-    };
+        _SystemGenerators.clear();
+        _bPrepared = false;
+        UpdateOctreeAggregates();
+    }
+}
 
-    struct MostOblateness
+Astro::FStellarSystem* FUniverse::GetStellarSystem(std::size_t DistanceRank)
+{
+    if (!_bOnDemand)
     {
-        float Oblateness{};
-        const Astro::AStar* Star = nullptr;
-    };
+        return IsStellarSystemReady(DistanceRank) ? &_StellarSystems[DistanceRank] : nullptr;
+    }
 
-    auto FormatTitle = []() -> std::string
+    if (DistanceRank >= _StellarSlots.size())
     {
-        return std::format("{:>6} {:>6} {:>8} {:>8} {:7} {:>5} {:>13} {:>8} {:>8} {:>11} {:>8} {:>9} {:>5} {:>15} {:>9} {:>8}",
-                           "InMass", "Mass", "Radius", "Age", "Class", "FeH", "Lum", "Teff", "CoreTemp", "CoreDensity", "Mdot", "WindSpeed", "Phase", "Magnetic", "Lifetime", "Oblateness");
-    };
+        return nullptr;
+    }
 
-    auto FormatInfo = [](const Astro::AStar* Star) -> std::string
+    std::scoped_lock Lock(_MaterializationMutex);
+    auto& System = _MaterializedSystems[DistanceRank];
+    if (System == nullptr)
     {
-        if (Star == nullptr)
-        {
-            return "No star generated.";
-        }
+        // 轨道中保存了指向质心和恒星的指针，系统必须直接在最终的存储位置上生成
+        System = std::make_unique<Astro::FStellarSystem>();
+        MaterializeStellarSystem(DistanceRank, _SystemGenerators.front(), *System);
+    }
 
-        return std::format("{:6.2f} {:6.2f} {:8.2f} {:8.2E} {:7} {:5.2f} {:13.4f} {:8.1f} {:8.2E} {:11.2E} {:8.2E} {:9} {:5} {:15.5f} {:9.2E} {:8.2f}",
-                           Star->GetInitialMass() / kSolarMass,
-                           Star->GetMass() / kSolarMass,
-                           Star->GetRadius() / kSolarRadius,
-                           Star->GetAge(),
-                           Star->GetStellarClass().ToString(),
-                           Star->GetFeH(),
-                           Star->GetLuminosity() / kSolarLuminosity,
-                           // kSolarAbsoluteMagnitude - 2.5 * std::log10(Star->GetLuminosity() / kSolarLuminosity),
-                           Star->GetTeff(),
-                           Star->GetCoreTemp(),
-                           Star->GetCoreDensity(),
-                           Star->GetStellarWindMassLossRate() * kYearToSecond / kSolarMass,
-                           static_cast<int>(std::round(Star->GetStellarWindSpeed())),
-                           static_cast<int>(Star->GetEvolutionPhase()),
-                           Star->GetSurfaceZ(),
-                           // Star->GetSurfaceEnergeticNuclide(),
-                           // Star->GetSurfaceVolatiles(),
-                           // Star->GetMagneticField(),
-                           Star->GetLifetime(),
-                           Star->GetOblateness());
-    };
+    return System.get();
+}
 
-    auto CountClass = [](const Astro::FStellarClass::FSpectralType& SpectralType, std::array<std::size_t, 7>& Type)
+Astro::AStar* FUniverse::GetStar(std::string_view StarName)
+{
+    auto Location = FindStar(StarName);
+    if (!Location.has_value())
     {
-        switch (SpectralType.HSpectralClass)
-        {
-        case Astro::FStellarClass::ESpectralClass::kSpectral_O:
-            ++Type[kTypeOIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_B:
-            ++Type[kTypeBIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_A:
-            ++Type[kTypeAIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_F:
-            ++Type[kTypeFIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_G:
-            ++Type[kTypeGIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_K:
-            ++Type[kTypeKIndex];
-            break;
-        case Astro::FStellarClass::ESpectralClass::kSpectral_M:
-            ++Type[kTypeMIndex];
-            break;
-        }
-    };
+        return nullptr;
+    }
 
-    auto CountMostLuminous = [](const std::unique_ptr<Astro::AStar>& Star, MostLuminous& MostLuminousStar)
+    Astro::FStellarSystem* System = GetStellarSystem(Location->DistanceRank);
+    if (System == nullptr || Location->StarIndex >= System->StarsData().size())
     {
-        double LuminositySol = 0.0;
-        LuminositySol = Star->GetLuminosity() / kSolarLuminosity;
-        if (MostLuminousStar.LuminositySol < LuminositySol)
-        {
-            MostLuminousStar.LuminositySol = LuminositySol;
-            MostLuminousStar.Star = Star.get();
-        }
-    };
+        return nullptr;
+    }
 
-    auto CountMostMassive = [](const std::unique_ptr<Astro::AStar>& Star, MostMassive& MostMassiveStar)
-    {
-        double MassSol = 0.0;
-        MassSol = Star->GetMass() / kSolarMass;
-        if (MostMassiveStar.MassSol < MassSol)
-        {
-            MostMassiveStar.MassSol = MassSol;
-            MostMassiveStar.Star = Star.get();
-        }
-    };
+    // 单星系统的恒星没有后缀，双星系统的成员必须带后缀，这里用完整的名字校验一次
+    Astro::AStar* Star = System->StarsData()[Location->StarIndex].get();
+    return Star->GetName() == StarName ? Star : nullptr;
+}
 
-    auto CountLargest = [](const std::unique_ptr<Astro::AStar>& Star, Largest& LargestStar)
+std::optional<FUniverse::FStarLocation> FUniverse::FindStar(std::string_view StarName) const
+{
+    // 星表名的格式为 STAR-<距离排名>，双星系统的成员再加上空格和 A, B, ... 后缀，名字本身就是索引，不需要额外的查找表
+    constexpr std::string_view kPrefix = "STAR-";
+    if (!StarName.starts_with(kPrefix))
     {
-        float RadiusSol = 0.0f;
-        RadiusSol = Star->GetRadius() / kSolarRadius;
-        if (LargestStar.RadiusSol < RadiusSol)
-        {
-            LargestStar.RadiusSol = RadiusSol;
-            LargestStar.Star = Star.get();
-        }
-    };
+        return std::nullopt;
+    }
+
+    StarName.remove_prefix(kPrefix.size());
 
-    auto CountHottest = [](const std::unique_ptr<Astro::AStar>& Star, Hottest& HottestStar)
+    FStarLocation Location;
+    const char* NameEnd = StarName.data() + StarName.size();
+    auto [Next, Error]  = std::from_chars(StarName.data(), NameEnd, Location.DistanceRank);
+    if (Error != std::errc() || Location.DistanceRank >= _StellarSlots.size())
     {
-        float Teff = 0.0f;
-        Teff = Star->GetTeff();
-        if (HottestStar.Teff < Teff)
-        {
-            HottestStar.Teff = Teff;
-            HottestStar.Star = Star.get();
-        }
-    };
+        return std::nullopt;
+    }
 
-    auto CountOldest = [](const std::unique_ptr<Astro::AStar>& Star, Oldest& OldestStar)
+    std::string_view Suffix(Next, NameEnd);
+    if (Suffix.size() == 2 && Suffix[0] == ' ' && Suffix[1] >= 'A' && Suffix[1] <= 'Z')
     {
-        double Age = 0.0;
-        Age = Star->GetAge();
-        if (OldestStar.Age < Age)
-        {
-            OldestStar.Age = Age;
-            OldestStar.Star = Star.get();
-        }
-    };
+        Location.StarIndex = Suffix[1] - 'A';
+    }
+    else if (!Suffix.empty())
+    {
+        return std::nullopt;
+    }
 
-    auto CountMostOblateness = [](const std::unique_ptr<Astro::AStar>& Star, MostOblateness& MostOblatenessStar)
+    return Location;
+}
+
+std::span<Astro::FStellarSystem* const> FUniverse::GetLeafStellarSystems(const FNodeType& LeafNode) const
+{
+    // 一次性生成时每个叶子节点都链接了所在格子的恒星系统，按需生成时没有链接
+    return _Octree->GetLinks(LeafNode);
+}
+
+const System::Spatial::TOctree<Astro::FStellarSystem>* FUniverse::GetOctree() const
+{
+    return _Octree.get();
+}
+
+void FUniverse::UpdateOctreeAggregates()
+{
+    _Octree->BuildAggregates([this](const glm::vec3&, Astro::FStellarSystem* System) -> float
     {
-        float Oblateness = 0.0f;
-        Oblateness = Star->GetOblateness();
-        if (MostOblatenessStar.Oblateness < Oblateness)
+        if (System == nullptr || !IsStellarSystemReady(System - _StellarSystems.data()))
         {
-            MostOblatenessStar.Oblateness = Oblateness;
-            MostOblatenessStar.Star = Star.get();
+            return 0.0f;
         }
-    };
 
-    MostLuminous MostLuminousMainSequence;
-    MostLuminous MostLuminousSubgiant;
-    MostLuminous MostLuminousGiant;
-    MostLuminous MostLuminousBrightGiant;
-    MostLuminous MostLuminousSupergiant;
-    MostLuminous MostLuminousHypergiant;
-    MostLuminous MostLuminousWolfRayet;
-
-    MostMassive MostMassiveMainSequence;
-    MostMassive MostMassiveSubgiant;
-    MostMassive MostMassiveGiant;
-    MostMassive MostMassiveBrightGiant;
-    MostMassive MostMassiveSupergiant;
-    MostMassive MostMassiveHypergiant;
-    MostMassive MostMassiveWolfRayet;
-
-    Largest LargestMainSequence;
-    Largest LargestSubgiant;
-    Largest LargestGiant;
-    Largest LargestBrightGiant;
-    Largest LargestSupergiant;
-    Largest LargestHypergiant;
-    Largest LargestWolfRayet;
-
-    Hottest HottestMainSequence;
-    Hottest HottestSubgiant;
-    Hottest HottestGiant;
-    Hottest HottestBrightGiant;
-    Hottest HottestSupergiant;
-    Hottest HottestHypergiant;
-    Hottest HottestWolfRayet;
-
-    Oldest OldestMainSequence;
-    Oldest OldestSubgiant;
-    Oldest OldestGiant;
-    Oldest OldestBrightGiant;
-    Oldest OldestSupergiant;
-    Oldest OldestHypergiant;
-    Oldest OldestWolfRayet;
-
-    MostOblateness MostOblatenessMainSequence;
-    MostOblateness MostOblatenessSubgiant;
-    MostOblateness MostOblatenessGiant;
-    MostOblateness MostOblatenessBrightGiant;
-    MostOblateness MostOblatenessSupergiant;
-    MostOblateness MostOblatenessHypergiant;
-    MostOblateness MostOblatenessWolfRayet;
-
-    std::println("Star statistics results:");
-    std::println("{}", FormatTitle());
-    std::println("");
-
-    for (auto& System : _StellarSystems)
-    {
-        for (auto& Star : System.StarsData())
+        double Luminosity = 0.0;
+        for (const auto& Star : System->StarsData())
         {
-            ++TotalStars;
-
-            if (Star->GetIsSingleStar())
-            {
-                ++TotalSingles;
-            }
-            else
-            {
-                ++TotalBinarys;
-            }
+            Luminosity += Star->GetLuminosity();
+        }
 
-            const auto& Class = Star->GetStellarClass();
-            Astro::FStellarClass::EStellarType StellarType = Class.GetStellarType();
-            if (StellarType != Astro::FStellarClass::EStellarType::kNormalStar)
-            {
-                switch (StellarType)
-                {
-                case Astro::FStellarClass::EStellarType::kBlackHole:
-                    ++BlackHoles;
-                    break;
-                case Astro::FStellarClass::EStellarType::kNeutronStar:
-                    ++NeutronStars;
-                    break;
-                case Astro::FStellarClass::EStellarType::kWhiteDwarf:
-                    ++WhiteDwarfs;
-                    break;
-                default:
-                    break;
-                }
+        return static_cast<float>(Luminosity / kSolarLuminosity);
+    });
+}
 
-                continue;
-            }
+void FUniverse::ReleaseStellarSystem(std::size_t DistanceRank)
+{
+    std::scoped_lock Lock(_MaterializationMutex);
+    _MaterializedSystems.erase(DistanceRank);
+}
 
-            Astro::FStellarClass::FSpectralType SpectralType = Class.Data();
+bool FUniverse::IsStellarSystemReady(std::size_t DistanceRank) const
+{
+    if (_bOnDemand)
+    {
+        return DistanceRank < _StellarSlots.size();
+    }
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_Unknown)
-            {
-                if (SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WC ||
-                    SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WN ||
-                    SpectralType.HSpectralClass == Astro::FStellarClass::ESpectralClass::kSpectral_WO)
-                {
-                    ++WolfRayet;
-                    CountMostLuminous(Star, MostLuminousWolfRayet);
-                    CountMostMassive(Star, MostMassiveWolfRayet);
-                    CountLargest(Star, LargestWolfRayet);
-                    CountHottest(Star, HottestWolfRayet);
-                    CountOldest(Star, OldestWolfRayet);
-                    CountMostOblateness(Star, MostOblatenessWolfRayet);
-                    continue;
-                }
-            }
+    if (DistanceRank >= _GenerationIndices.size())
+    {
+        return false;
+    }
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_0 ||
-                SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_IaPlus)
-            {
-                CountClass(SpectralType, Hypergiants);
-                CountMostLuminous(Star, MostLuminousHypergiant);
-                CountMostMassive(Star, MostMassiveHypergiant);
-                CountLargest(Star, LargestHypergiant);
-                CountHottest(Star, HottestHypergiant);
-                CountOldest(Star, OldestHypergiant);
-                CountMostOblateness(Star, MostOblatenessHypergiant);
-                continue;
-            }
+    return _GenerationIndices[DistanceRank] < _ReadySystemCount.load(std::memory_order_acquire);
+}
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_Ia ||
-                SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_Iab ||
-                SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_Ib)
-            {
-                CountClass(SpectralType, Supergiants);
-                CountMostLuminous(Star, MostLuminousSupergiant);
-                CountMostMassive(Star, MostMassiveSupergiant);
-                CountLargest(Star, LargestSupergiant);
-                CountHottest(Star, HottestSupergiant);
-                CountOldest(Star, OldestSupergiant);
-                CountMostOblateness(Star, MostOblatenessSupergiant);
-                continue;
-            }
+std::size_t FUniverse::GetReadySystemCount() const
+{
+    return _ReadySystemCount.load(std::memory_order_acquire);
+}
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_II)
-            {
-                CountClass(SpectralType, BrightGiants);
-                CountMostLuminous(Star, MostLuminousBrightGiant);
-                CountMostMassive(Star, MostMassiveBrightGiant);
-                CountLargest(Star, LargestBrightGiant);
-                CountHottest(Star, HottestBrightGiant);
-                CountOldest(Star, OldestBrightGiant);
-                CountMostOblateness(Star, MostOblatenessBrightGiant);
-                continue;
-            }
+std::size_t FUniverse::GetMaterializedSystemCount() const
+{
+    std::scoped_lock Lock(_MaterializationMutex);
+    return _MaterializedSystems.size();
+}
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_III)
-            {
-                CountClass(SpectralType, Giants);
-                CountMostLuminous(Star, MostLuminousGiant);
-                CountMostMassive(Star, MostMassiveGiant);
-                CountLargest(Star, LargestGiant);
-                CountHottest(Star, HottestGiant);
-                CountOldest(Star, OldestGiant);
-                CountMostOblateness(Star, MostOblatenessGiant);
-                continue;
-            }
+std::size_t FUniverse::GetSlotCount() const
+{
+    return _StellarSlots.size();
+}
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_IV)
-            {
-                CountClass(SpectralType, Subgiants);
-                CountMostLuminous(Star, MostLuminousSubgiant);
-                CountMostMassive(Star, MostMassiveSubgiant);
-                CountLargest(Star, LargestSubgiant);
-                CountHottest(Star, HottestSubgiant);
-                CountOldest(Star, OldestSubgiant);
-                CountMostOblateness(Star, MostOblatenessSubgiant);
-                continue;
-            }
+bool FUniverse::ReplaceStar(std::size_t DistanceRank, const Astro::AStar& StarData)
+{
+    return ReplaceStar(DistanceRank, 0, StarData);
+}
 
-            if (SpectralType.LuminosityClass == Astro::FStellarClass::ELuminosityClass::kLuminosity_V)
-            {
-                CountClass(SpectralType, MainSequence);
-                CountMostLuminous(Star, MostLuminousMainSequence);
-                CountMostMassive(Star, MostMassiveMainSequence);
-                CountLargest(Star, LargestMainSequence);
-                CountHottest(Star, HottestMainSequence);
-                CountOldest(Star, OldestMainSequence);
-                CountMostOblateness(Star, MostOblatenessMainSequence);
-                continue;
-            }
-        }
+bool FUniverse::ReplaceStar(std::size_t DistanceRank, std::size_t StarIndex, const Astro::AStar& StarData)
+{
+    Astro::FStellarSystem* System = GetStellarSystem(DistanceRank);
+    if (System == nullptr)
+    {
+        // 渐进式生成时目标可能还没有生成，等待后台生成完成后再取
+        WaitForCompletion();
+        System = GetStellarSystem(DistanceRank);
     }
 
-    std::println("Most luminous main sequence star: luminosity: {}", MostLuminousMainSequence.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousMainSequence.Star));
-    std::println("Most luminous Wolf-Rayet star: luminosity: {}", MostLuminousWolfRayet.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousWolfRayet.Star));
-    std::println("Most luminous subgiant star: luminosity: {}", MostLuminousSubgiant.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousSubgiant.Star));
-    std::println("Most luminous giant star: luminosity: {}", MostLuminousGiant.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousGiant.Star));
-    std::println("Most luminous bright giant star: luminosity: {}", MostLuminousBrightGiant.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousBrightGiant.Star));
-    std::println("Most luminous supergiant star: luminosity: {}", MostLuminousSupergiant.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousSupergiant.Star));
-    std::println("Most luminous hypergiant star: luminosity: {}", MostLuminousHypergiant.LuminositySol);
-    std::println("{}", FormatInfo(MostLuminousHypergiant.Star));
-    std::println("");
-    std::println("Most massive main sequence star: mass: {}", MostMassiveMainSequence.MassSol);
-    std::println("{}", FormatInfo(MostMassiveMainSequence.Star));
-    std::println("Most massive Wolf-Rayet star: mass: {}", MostMassiveWolfRayet.MassSol);
-    std::println("{}", FormatInfo(MostMassiveWolfRayet.Star));
-    std::println("Most massive subgiant star: mass: {}", MostMassiveSubgiant.MassSol);
-    std::println("{}", FormatInfo(MostMassiveSubgiant.Star));
-    std::println("Most massive giant star: mass: {}", MostMassiveGiant.MassSol);
-    std::println("{}", FormatInfo(MostMassiveGiant.Star));
-    std::println("Most massive bright giant star: mass: {}", MostMassiveBrightGiant.MassSol);
-    std::println("{}", FormatInfo(MostMassiveBrightGiant.Star));
-    std::println("Most massive supergiant star: mass: {}", MostMassiveSupergiant.MassSol);
-    std::println("{}", FormatInfo(MostMassiveSupergiant.Star));
-    std::println("Most massive hypergiant star: mass: {}", MostMassiveHypergiant.MassSol);
-    std::println("{}", FormatInfo(MostMassiveHypergiant.Star));
-    std::println("");
-    std::println("Largest main sequence star: radius: {}", LargestMainSequence.RadiusSol);
-    std::println("{}", FormatInfo(LargestMainSequence.Star));
-    std::println("Largest Wolf-Rayet star: radius: {}", LargestWolfRayet.RadiusSol);
-    std::println("{}", FormatInfo(LargestWolfRayet.Star));
-    std::println("Largest subgiant star: radius: {}", LargestSubgiant.RadiusSol);
-    std::println("{}", FormatInfo(LargestSubgiant.Star));
-    std::println("Largest giant star: radius: {}", LargestGiant.RadiusSol);
-    std::println("{}", FormatInfo(LargestGiant.Star));
-    std::println("Largest bright giant star: radius: {}", LargestBrightGiant.RadiusSol);
-    std::println("{}", FormatInfo(LargestBrightGiant.Star));
-    std::println("Largest supergiant star: radius: {}", LargestSupergiant.RadiusSol);
-    std::println("{}", FormatInfo(LargestSupergiant.Star));
-    std::println("Largest hypergiant star: radius: {}", LargestHypergiant.RadiusSol);
-    std::println("{}", FormatInfo(LargestHypergiant.Star));
-    std::println("");
-    std::println("Hottest main sequence star: Teff: {}", HottestMainSequence.Teff);
-    std::println("{}", FormatInfo(HottestMainSequence.Star));
-    std::println("Hottest Wolf-Rayet star: Teff: {}", HottestWolfRayet.Teff);
-    std::println("{}", FormatInfo(HottestWolfRayet.Star));
-    std::println("Hottest subgiant star: Teff: {}", HottestSubgiant.Teff);
-    std::println("{}", FormatInfo(HottestSubgiant.Star));
-    std::println("Hottest giant star: Teff: {}", HottestGiant.Teff);
-    std::println("{}", FormatInfo(HottestGiant.Star));
-    std::println("Hottest bright giant star: Teff: {}", HottestBrightGiant.Teff);
-    std::println("{}", FormatInfo(HottestBrightGiant.Star));
-    std::println("Hottest supergiant star: Teff: {}", HottestSupergiant.Teff);
-    std::println("{}", FormatInfo(HottestSupergiant.Star));
-    std::println("Hottest hypergiant star: Teff: {}", HottestHypergiant.Teff);
-    std::println("{}", FormatInfo(HottestHypergiant.Star));
-    std::println("");
-    std::println("Oldest main sequence star: Age: {}", OldestMainSequence.Age);
-    std::println("{}", FormatInfo(OldestMainSequence.Star));
-    std::println("Oldest Wolf-Rayet star: Age: {}", OldestWolfRayet.Age);
-    std::println("{}", FormatInfo(OldestWolfRayet.Star));
-    std::println("Oldest subgiant star: Age: {}", OldestSubgiant.Age);
-    std::println("{}", FormatInfo(OldestSubgiant.Star));
-    std::println("Oldest giant star: Age: {}", OldestGiant.Age);
-    std::println("{}", FormatInfo(OldestGiant.Star));
-    std::println("Oldest bright giant star: Age: {}", OldestBrightGiant.Age);
-    std::println("{}", FormatInfo(OldestBrightGiant.Star));
-    std::println("Oldest supergiant star: Age: {}", OldestSupergiant.Age);
-    std::println("{}", FormatInfo(OldestSupergiant.Star));
-    std::println("Oldest hypergiant star: Age: {}", OldestHypergiant.Age);
-    std::println("{}", FormatInfo(OldestHypergiant.Star));
-    std::println("");
-    std::println("Most oblateness main sequence star: Oblateness: {}", MostOblatenessMainSequence.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessMainSequence.Star));
-    std::println("Most oblateness Wolf-Rayet star: Oblateness: {}", MostOblatenessWolfRayet.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessWolfRayet.Star));
-    std::println("Most oblateness subgiant star: Oblateness: {}", MostOblatenessSubgiant.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessSubgiant.Star));
-    std::println("Most oblateness giant star: Oblateness: {}", MostOblatenessGiant.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessGiant.Star));
-    std::println("Most oblateness bright giant star: Oblateness: {}", MostOblatenessBrightGiant.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessBrightGiant.Star));
-    std::println("Most oblateness supergiant star: Oblateness: {}", MostOblatenessSupergiant.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessSupergiant.Star));
-    std::println("Most oblateness hypergiant star: Oblateness: {}", MostOblatenessHypergiant.Oblateness);
-    std::println("{}", FormatInfo(MostOblatenessHypergiant.Star));
-
-    std::size_t TotalMainSequence = 0;
-    for (std::size_t Count : MainSequence)
-    {
-        TotalMainSequence += Count;
+    if (System == nullptr || StarIndex >= System->StarsData().size())
+    {
+        return false;
     }
 
-    std::println("");
-    std::println("Total main sequence: {}", TotalMainSequence);
-    std::println("Total main sequence rate: {}", TotalMainSequence / static_cast<double>(TotalStars));
-    std::println("Total O type star rate: {}", static_cast<double>(MainSequence[kTypeOIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total B type star rate: {}", static_cast<double>(MainSequence[kTypeBIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total A type star rate: {}", static_cast<double>(MainSequence[kTypeAIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total F type star rate: {}", static_cast<double>(MainSequence[kTypeFIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total G type star rate: {}", static_cast<double>(MainSequence[kTypeGIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total K type star rate: {}", static_cast<double>(MainSequence[kTypeKIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total M type star rate: {}", static_cast<double>(MainSequence[kTypeMIndex]) / static_cast<double>(TotalMainSequence));
-    std::println("Total Wolf-Rayet / O main star rate: {}", static_cast<double>(WolfRayet) / static_cast<double>(MainSequence[kTypeOIndex]));
-
-    std::println("O type main sequence: {}\nB type main sequence: {}\nA type main sequence: {}\nF type main sequence: {}\nG type main sequence: {}\nK type main sequence: {}\nM type main sequence: {}",
-                 MainSequence[kTypeOIndex], MainSequence[kTypeBIndex], MainSequence[kTypeAIndex], MainSequence[kTypeFIndex], MainSequence[kTypeGIndex], MainSequence[kTypeKIndex], MainSequence[kTypeMIndex]);
-    std::println("O type subgiants: {}\nB type subgiants: {}\nA type subgiants: {}\nF type subgiants: {}\nG type subgiants: {}\nK type subgiants: {}\nM type subgiants: {}",
-                 Subgiants[kTypeOIndex], Subgiants[kTypeBIndex], Subgiants[kTypeAIndex], Subgiants[kTypeFIndex], Subgiants[kTypeGIndex], Subgiants[kTypeKIndex], Subgiants[kTypeMIndex]);
-    std::println("O type giants: {}\nB type giants: {}\nA type giants: {}\nF type giants: {}\nG type giants: {}\nK type giants: {}\nM type giants: {}",
-                 Giants[kTypeOIndex], Giants[kTypeBIndex], Giants[kTypeAIndex], Giants[kTypeFIndex], Giants[kTypeGIndex], Giants[kTypeKIndex], Giants[kTypeMIndex]);
-    std::println("O type bright giants: {}\nB type bright giants: {}\nA type bright giants: {}\nF type bright giants: {}\nG type bright giants: {}\nK type bright giants: {}\nM type bright giants: {}",
-                 BrightGiants[kTypeOIndex], BrightGiants[kTypeBIndex], BrightGiants[kTypeAIndex], BrightGiants[kTypeAIndex], BrightGiants[kTypeFIndex], BrightGiants[kTypeGIndex], BrightGiants[kTypeMIndex]);
-    std::println("O type supergiants: {}\nB type supergiants: {}\nA type supergiants: {}\nF type supergiants: {}\nG type supergiants: {}\nK type supergiants: {}\nM type supergiants: {}",
-                 Supergiants[kTypeOIndex], Supergiants[kTypeBIndex], Supergiants[kTypeAIndex], Supergiants[kTypeFIndex], Supergiants[kTypeGIndex], Supergiants[kTypeKIndex], Supergiants[kTypeMIndex]);
-    std::println("O type hypergiants: {}\nB type hypergiants: {}\nA type hypergiants: {}\nF type hypergiants: {}\nG type hypergiants: {}\nK type hypergiants: {}\nM type hypergiants: {}",
-                 Hypergiants[kTypeOIndex], Hypergiants[kTypeBIndex], Hypergiants[kTypeAIndex], Hypergiants[kTypeFIndex], Hypergiants[kTypeGIndex], Hypergiants[kTypeKIndex], Hypergiants[kTypeMIndex]);
-    std::println("Wolf-Rayet stars: {}", WolfRayet);
-    std::println("White dwarfs: {}\nNeutron stars: {}\nBlack holes: {}", WhiteDwarfs, NeutronStars, BlackHoles);
-    std::println("");
-    std::println("Number of single stars: {}", TotalSingles);
-    std::println("Number of binary stars: {}", TotalBinarys);
-    std::println("");
-}
+    // 原地赋值，轨道中保存的恒星指针依然有效。名字和多星标记保持不变，按名字查找的结果也不会失效
+    auto& Star = *System->StarsData()[StarIndex];
+    std::string Name        = Star.GetName();
+    bool        bSingleStar = Star.GetIsSingleStar();
 
-void FUniverse::GenerateStars(int MaxThread)
-{
-    NpgsCoreInfo("Initializating and generating basic properties...");
-    std::vector<SysGen::FStellarGenerator> Generators;
-    std::vector<SysGen::FStellarGenerator::FBasicProperties> BasicProperties;
-
-    auto CreateGenerators =
-    [&, this](SysGen::FStellarGenerator::EStellarTypeGenerationOption StellarTypeOption =
-              SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
-              float MassLowerLimit = 0.1f,  float MassUpperLimit = 300.0f,
-              SysGen::FStellarGenerator::EGenerationDistribution MassDistribution =
-              SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
-              float AgeLowerLimit  = 0.0f,  float AgeUpperLimit  = 1.26e10f,
-              SysGen::FStellarGenerator::EGenerationDistribution AgeDistribution  = 
-              SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
-              float FeHLowerLimit  = -4.0f, float FeHUpperLimit  = 0.5f,
-              SysGen::FStellarGenerator::EGenerationDistribution FeHDistribution  =
-              SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf) -> void
-    {
-        for (int i = 0; i != MaxThread; ++i)
-        {
-            std::vector<std::uint32_t> Seeds(32);
-            for (int i = 0; i != 32; ++i)
-            {
-                Seeds[i] = _SeedGenerator(_RandomEngine);
-            }
+    Star = StarData;
+    Star.SetName(Name);
+    Star.SetIsSingleStar(bSingleStar);
 
-            std::shuffle(Seeds.begin(), Seeds.end(), _RandomEngine);
-            std::seed_seq SeedSequence(Seeds.begin(), Seeds.end());
-
-            SysGen::FStellarGenerator::FStellarGenerationInfo GenerationInfo
-            {
-                .SeedSequence       = &SeedSequence,
-                .StellarTypeOption  = StellarTypeOption,
-                .MultiplicityOption = SysGen::FStellarGenerator::EMultiplicityGenerationOption::kSingleStar,
-                .UniverseAge        = _UniverseAge,
-                .MassLowerLimit     = MassLowerLimit,
-                .MassUpperLimit     = MassUpperLimit,
-                .MassDistribution   = MassDistribution,
-                .AgeLowerLimit      = AgeLowerLimit,
-                .AgeUpperLimit      = AgeUpperLimit,
-                .AgeDistribution    = AgeDistribution,
-                .FeHLowerLimit      = FeHLowerLimit,
-                .FeHUpperLimit      = FeHUpperLimit,
-                .FeHDistribution    = FeHDistribution
-            };
+    return true;
+}
 
-            Generators.push_back(GenerationInfo);
-        }
-    };
+bool FUniverse::ReplaceStar(std::string_view StarName, const Astro::AStar& StarData)
+{
+    auto Location = FindStar(StarName);
+    if (!Location.has_value())
+    {
+        return false;
+    }
 
-    // 生成基础属性
-    auto GenerateBasicProperties = [&, this](std::size_t NumStars) -> void
+    if (GetStar(StarName) == nullptr)
     {
-        for (std::size_t i = 0; i != NumStars; ++i)
+        WaitForCompletion();
+        if (GetStar(StarName) == nullptr)
         {
-            std::size_t ThreadId = i % Generators.size();
-            BasicProperties.push_back(Generators[ThreadId].GenerateBasicProperties());
+            return false;
         }
-    };
+    }
 
-    // 特殊星基础参数设置
-    if (_ExtraGiantCount != 0)
+    return ReplaceStar(Location->DistanceRank, Location->StarIndex, StarData);
+}
+
+FStellarStatistics::FResult FUniverse::CountStars()
+{
+    WaitForCompletion();
+
+    if (!_bOnDemand)
     {
-        Generators.clear();
-        CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kGiant, 1.0f, 35.0f);
-        GenerateBasicProperties(_ExtraGiantCount);
+        auto Result = _Statistics.Compute(_StellarSystems, _ThreadPool, _ThreadPool->GetMaxThreadCount());
+        FStellarStatistics::Print(Result);
+        return Result;
     }
 
-    if (_ExtraMassiveStarCount != 0)
+    // 按需模式下只有常驻内存的恒星系统可以统计。按距离排名排序，并列时的结果与完整统计的规则一致
+    // 统计结束后系统可能被释放，结果中的极值恒星改为副本
+    std::scoped_lock Lock(_MaterializationMutex);
+    std::vector<std::pair<std::size_t, Astro::FStellarSystem*>> RankedSystems;
+    RankedSystems.reserve(_MaterializedSystems.size());
+    for (const auto& [DistanceRank, System] : _MaterializedSystems)
     {
-        Generators.clear();
-        CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
-                         20.0f, 300.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
-                         0.0f,  3.5e6f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform);
-        GenerateBasicProperties(_ExtraMassiveStarCount);
+        RankedSystems.emplace_back(DistanceRank, System.get());
     }
 
-    if (_ExtraNeutronStarCount != 0)
+    std::ranges::sort(RankedSystems);
+    std::vector<Astro::FStellarSystem*> Systems;
+    Systems.reserve(RankedSystems.size());
+    for (const auto& [DistanceRank, System] : RankedSystems)
     {
-        Generators.clear();
-        CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kDeathStar,
-                         10.0f, 20.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
-                         1e7f,  1e8f,  SysGen::FStellarGenerator::EGenerationDistribution::kUniformByExponent);
-        GenerateBasicProperties(_ExtraNeutronStarCount);
+        Systems.push_back(System);
     }
 
-    if (_ExtraBlackHoleCount != 0)
+    NpgsCoreInfo("Counting {} materialized of {} stellar systems in on-demand mode.", Systems.size(), _StellarSlots.size());
+    auto Result = _Statistics.Compute(Systems, _ThreadPool, _ThreadPool->GetMaxThreadCount());
+    FStellarStatistics::Detach(Result);
+    FStellarStatistics::Print(Result);
+
+    return Result;
+}
+
+FStellarStatistics& FUniverse::GetStatistics()
+{
+    return _Statistics;
+}
+
+void FUniverse::SetGenerationToken(std::shared_ptr<FGenerationToken> Token)
+{
+    WaitForCompletion();
+    _GenerationToken = std::move(Token);
+}
+
+bool FUniverse::CanResumeGeneration(const glm::vec3& FocusPosition) const
+{
+    return _bPrepared && !_bOnDemand && FocusPosition == _GenerationFocus &&
+           GetReadySystemCount() != _GenerationOrder.size();
+}
+
+void FUniverse::CheckCancellation() const
+{
+    if (_GenerationToken != nullptr)
     {
-        Generators.clear();
-        CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
-                         35.0f,  300.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
-                         1e7f, 1.26e10f, SysGen::FStellarGenerator::EGenerationDistribution::kFromPdf,
-                         -2.0, 0.5);
-        GenerateBasicProperties(_ExtraBlackHoleCount);
+        _GenerationToken->ThrowIfCancelled();
     }
+}
 
-    if (_ExtraMergeStarCount != 0)
+void FUniverse::BeginGenerationPhase(FGenerationToken::EPhase Phase, std::size_t Total) const
+{
+    if (_GenerationToken != nullptr)
     {
-        Generators.clear();
-        CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kMergeStar,
-                         0.0f, 0.0f, SysGen::FStellarGenerator::EGenerationDistribution::kUniform,
-                         1e6f, 1e8f, SysGen::FStellarGenerator::EGenerationDistribution::kUniformByExponent);
-        GenerateBasicProperties(_ExtraMergeStarCount);
+        _GenerationToken->BeginPhase(Phase, Total);
     }
+}
 
-    std::size_t CommonStarsCount =
-        _StarCount - _ExtraGiantCount - _ExtraMassiveStarCount - _ExtraNeutronStarCount - _ExtraBlackHoleCount - _ExtraMergeStarCount;
+void FUniverse::PrepareStellarSystems(int MaxThread, const glm::vec3& FocusPosition)
+{
+    WaitForCompletion();
 
-    Generators.clear();
-    CreateGenerators(SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom, 0.075f);
-    GenerateBasicProperties(CommonStarsCount);
+    // 准备过程中被取消时格子和生成顺序可能不完整，只能重新准备
+    _bPrepared = false;
+    _ReadySystemCount.store(0, std::memory_order_release);
 
-    NpgsCoreInfo("Interpolating stellar data as {} physical cores...", MaxThread);
+    // 生成器的构造与格子无关，和八叉树构建同时进行；链接和生成顺序只依赖格子，两者也可以同时进行
+    std::vector<FNodeType*> SlotNodes;
+    Runtime::Thread::FTaskGraph TaskGraph;
 
-    std::vector<Astro::AStar> Stars = InterpolateStars(MaxThread, Generators, BasicProperties);
+    auto SlotTask = TaskGraph.AddTask([&]() -> void
+    {
+        NpgsCoreInfo("Building stellar octree in {} threads...", MaxThread);
+        GenerateSlots(0.1f, _StarCount, 0.004f);
 
-    NpgsCoreInfo("Building stellar octree in 8 threads...");
-    GenerateSlots(0.1f, _StarCount, 0.004f);
+        NpgsCoreInfo("Assigning seeds to stellar slots...");
+        SlotNodes = CollectStellarSlots(MaxThread);
+    });
 
-    NpgsCoreInfo("Linking positions in octree to stellar systems...");
-    _StellarSystems.reserve(_StarCount);
-    std::shuffle(Stars.begin(), Stars.end(), _RandomEngine);
-    std::vector<glm::vec3> Slots;
-    OctreeLinkToStellarSystems(Stars, Slots);
+    auto LinkTask = TaskGraph.AddTask([&]() -> void
+    {
+        NpgsCoreInfo("Linking positions in octree to stellar systems...");
+        OctreeLinkToStellarSystems(SlotNodes);
+    });
 
-    NpgsCoreInfo("Generating binary stars...");
-    GenerateBinaryStars(MaxThread);
+    auto OrderTask = TaskGraph.AddTask([&]() -> void
+    {
+        BuildGenerationOrder(FocusPosition);
+    });
 
-    NpgsCoreInfo("Sorting...");
-    std::sort(Slots.begin(), Slots.end(), [](const glm::vec3& Point1, const glm::vec3& Point2)
+    TaskGraph.AddTask([&]() -> void
     {
-        return glm::length(Point1) < glm::length(Point2);
+        NpgsCoreInfo("Initializating stellar generators...");
+        CreateSystemGenerators(MaxThread * _kInFlightChunksPerThread);
     });
 
-    NpgsCoreInfo("Assigning name...");
-    std::string Name;
-    std::ostringstream Stream;
-    for (auto& System : _StellarSystems)
+    TaskGraph.AddDependency(SlotTask, LinkTask);
+    TaskGraph.AddDependency(SlotTask, OrderTask);
+    TaskGraph.Execute(_ThreadPool);
+
+    std::scoped_lock Lock(_MaterializationMutex);
+    _MaterializedSystems.clear();
+    _GenerationFocus = FocusPosition;
+    _bPrepared       = true;
+    _bOnDemand       = false;
+}
+
+void FUniverse::BuildGenerationOrder(const glm::vec3& FocusPosition)
+{
+    // 生成顺序按到焦点的距离排序，焦点为原点时与距离排名一致
+    std::size_t SystemCount = _StellarSlots.size();
+    _GenerationOrder.resize(SystemCount);
+    std::iota(_GenerationOrder.begin(), _GenerationOrder.end(), static_cast<std::size_t>(0));
+    if (FocusPosition != glm::vec3(0.0f))
     {
-        glm::vec3 Position = System.GetBaryPosition();
-        auto it = std::lower_bound(Slots.begin(), Slots.end(), Position,
-        [](const glm::vec3& Point1, const glm::vec3& Point2) -> bool
+        std::vector<float> Distances(SystemCount);
+        for (std::size_t i = 0; i != SystemCount; ++i)
+        {
+            glm::vec3 Offset = _StellarSlots[i].Position - FocusPosition;
+            Distances[i] = glm::dot(Offset, Offset);
+        }
+
+        std::stable_sort(_GenerationOrder.begin(), _GenerationOrder.end(),
+        [&Distances](std::size_t Rank1, std::size_t Rank2) -> bool
         {
-            return glm::length(Point1) < glm::length(Point2);
+            return Distances[Rank1] < Distances[Rank2];
         });
-        std::ptrdiff_t Offset = it - Slots.begin();
-        Stream << std::setfill('0') << std::setw(8) << std::to_string(Offset);
-        Name = "SYSTEM-" + Stream.str();
-        System.SetBaryName(Name).SetBaryDistanceRank(Offset);
+    }
+
+    _GenerationIndices.resize(SystemCount);
+    for (std::size_t i = 0; i != SystemCount; ++i)
+    {
+        _GenerationIndices[_GenerationOrder[i]] = i;
+    }
+}
+
+void FUniverse::GenerateStellarSystems(int MaxThread, std::size_t BeginIndex, std::size_t EndIndex)
+{
+    NpgsCoreInfo("Generating stellar systems [{}, {}) as {} physical cores...", BeginIndex, EndIndex, MaxThread);
+
+    // 按生成顺序分块流水线生成，每块在一个线程上依次完成采样、插值、伴星、命名和行星生成
+    // 在途的块数不超过生成器组数，中间结果只存在于块内，各块的不同步骤可以同时进行，不再有阶段之间的等待
+    // 第 k 块使用第 k % 组数 组生成器，窗口保证同一组生成器不会同时被两个块使用
+    std::size_t MaxInFlightChunks = _SystemGenerators.size();
+    std::deque<std::pair<std::size_t, std::future<void>>> InFlightChunks;
 
-        auto& Stars = System.StarsData();
-        if (Stars.size() > 1)
+    BeginGenerationPhase(FGenerationToken::EPhase::kStellarSystems, _GenerationOrder.size());
+    if (_GenerationToken != nullptr)
+    {
+        _GenerationToken->SetProgress(BeginIndex);
+    }
+
+    // 取消后不再提交新的块，在途的块照常完成并发布，已完成的前缀保持连续，之后可以从这里继续
+    bool bCancelled = false;
+    std::size_t ChunkIndex = 0;
+    std::size_t NextIndex  = BeginIndex;
+    while (NextIndex != EndIndex || !InFlightChunks.empty())
+    {
+        bCancelled = bCancelled || (_GenerationToken != nullptr && _GenerationToken->IsCancelled());
+        while (!bCancelled && NextIndex != EndIndex && InFlightChunks.size() < MaxInFlightChunks)
         {
-            std::sort(Stars.begin(), Stars.end(),
-            [](const std::unique_ptr<Astro::AStar>& Star1, std::unique_ptr<Astro::AStar>& Star2) -> bool
+            std::size_t ChunkEnd = std::min(NextIndex + _kSystemChunkSize, EndIndex);
+            auto* Generators = &_SystemGenerators[ChunkIndex++ % MaxInFlightChunks];
+            auto GenerateChunk = [this, NextIndex, ChunkEnd, Generators]() -> void
             {
-                return Star1->GetMass() > Star2->GetMass();
-            });
+                for (std::size_t Index = NextIndex; Index != ChunkEnd; ++Index)
+                {
+                    std::size_t DistanceRank = _GenerationOrder[Index];
+                    MaterializeStellarSystem(DistanceRank, *Generators, _StellarSystems[DistanceRank]);
+                }
+            };
 
-            char Rank = 'A';
-            for (auto& Star : Stars)
-            {
-                Star->SetName("STAR-" + Stream.str() + " " + Rank);
-                ++Rank;
-            }
+            // 放入后台生成通道，交互和 I/O 任务不会排在整批生成任务之后
+            InFlightChunks.emplace_back(ChunkEnd, _ThreadPool->SubmitToLane(
+                Runtime::Thread::FThreadPool::ETaskLane::kGeneration, std::move(GenerateChunk)));
+
+            NextIndex = ChunkEnd;
         }
-        else
+
+        if (InFlightChunks.empty())
         {
-            Stars.front()->SetName("STAR-" + Stream.str());
+            break;
         }
 
-        Stream.str("");
-        Stream.clear();
-    }
-
-    NpgsCoreInfo("Reset home stellar system...");
-    FNodeType* HomeNode = _Octree->Find(glm::vec3(0.0f), [](const FNodeType& Node) -> bool
-    {
-        if (Node.IsLeafNode())
+        // 按顺序等待最早提交的块，已完成的连续前缀立即发布
+        auto& [ChunkEnd, Future] = InFlightChunks.front();
+        try
         {
-            auto& Points = Node.GetPoints();
-            return std::find(Points.begin(), Points.end(), glm::vec3(0.0f)) != Points.end();
+            Future.get();
         }
-        else
+        catch (...)
         {
-            return false;
+            // 其余在途的块仍在使用生成器和恒星系统，等它们全部结束后再抛出，调用方才能安全地清理或析构
+            for (std::size_t i = 1; i < InFlightChunks.size(); ++i)
+            {
+                InFlightChunks[i].second.wait();
+            }
+
+            throw;
         }
-    });
 
-    auto* HomeSystem = HomeNode->GetLink([](Astro::FStellarSystem* System) -> bool
-    {
-        return System->GetBaryPosition() == glm::vec3(0.0f);
-    });
-    HomeNode->RemoveStorage();
-    HomeNode->AddPoint(glm::vec3(0.0f));
-    HomeSystem->SetBaryNormal(glm::vec2(0.0f));
+        _ReadySystemCount.store(ChunkEnd, std::memory_order_release);
+        if (_GenerationToken != nullptr)
+        {
+            _GenerationToken->SetProgress(ChunkEnd);
+        }
 
-    for (auto& Star : HomeSystem->StarsData())
+        InFlightChunks.pop_front();
+    }
+
+    if (bCancelled)
     {
-        Star->SetNormal(glm::vec3(0.0f));
+        NpgsCoreInfo("Stellar generation cancelled: {} of {} systems ready.", GetReadySystemCount(), _GenerationOrder.size());
+        CheckCancellation();
     }
 
-    NpgsCoreInfo("Stellar generation completed.");
+    NpgsCoreInfo("Stellar generation completed: {} of {} systems ready.", EndIndex, _GenerationOrder.size());
 }
 
-void FUniverse::FillStellarSystem(int MaxThread)
+void FUniverse::CreateSystemGenerators(int GeneratorCount)
 {
-    NpgsCoreInfo("Generating planets...");
-
-    std::vector<SysGen::FOrbitalGenerator> Generators;
+    // 生成器在使用前都会按格子重新播种，构造时使用的种子不影响生成结果
+    std::seed_seq SeedSequence;
 
-    for (int i = 0; i != MaxThread; ++i)
+    _SystemGenerators.clear();
+    _SystemGenerators.reserve(GeneratorCount);
+    for (int i = 0; i != GeneratorCount; ++i)
     {
-        std::vector<std::uint32_t> Seeds(32);
-        for (int i = 0; i != 32; ++i)
-        {
-            Seeds[i] = _SeedGenerator(_RandomEngine);
-        }
-
-        std::shuffle(Seeds.begin(), Seeds.end(), _RandomEngine);
-        std::seed_seq SeedSequence(Seeds.begin(), Seeds.end());
-
-        Generators.push_back(SeedSequence);
+        _SystemGenerators.emplace_back(SeedSequence, _UniverseAge);
     }
 }
 
-std::vector<Astro::AStar>
-FUniverse::InterpolateStars(int MaxThread, std::vector<SysGen::FStellarGenerator>& Generators,
-                            std::vector<SysGen::FStellarGenerator::FBasicProperties>& BasicProperties)
+void FUniverse::AssignName(Astro::FStellarSystem& System) const
 {
-    std::vector<std::vector<SysGen::FStellarGenerator::FBasicProperties>> PropertyLists(MaxThread);
-    std::vector<std::promise<std::vector<Astro::AStar>>> Promises(MaxThread);
-    std::vector<std::future<std::vector<Astro::AStar>>> ChunkFutures;
+    // 名字直接格式化到栈上的缓冲区，8 位编号的名字不超过 15 个字符，构造 std::string 时不会分配堆内存
+    std::array<char, 32> Buffer{};
+    std::size_t DistanceRank = System.GetBaryDistanceRank();
 
-    Runtime::Thread::MakeChunks(MaxThread, BasicProperties, PropertyLists, Promises, ChunkFutures);
+    auto FormatName = [&Buffer]<typename... Args>(std::format_string<Args...> Format, Args&&... Params) -> std::string_view
+    {
+        auto Result = std::format_to_n(Buffer.data(), Buffer.size(), Format, std::forward<Args>(Params)...);
+        return std::string_view(Buffer.data(), Result.out);
+    };
 
-    for (int i = 0; i != MaxThread; ++i)
+    System.SetBaryName(std::string(FormatName("SYSTEM-{:08}", DistanceRank)));
+
+    auto& Stars = System.StarsData();
+    if (Stars.size() > 1)
     {
-        _ThreadPool->Submit([&, i]() -> void
+        std::sort(Stars.begin(), Stars.end(),
+        [](const std::unique_ptr<Astro::AStar>& Star1, std::unique_ptr<Astro::AStar>& Star2) -> bool
         {
-            std::vector<Astro::AStar> Stars;
-            for (auto& Properties : PropertyLists[i])
-            {
-                Stars.push_back(Generators[i].GenerateStar(Properties));
-            }
-            Promises[i].set_value(std::move(Stars));
+            return Star1->GetMass() > Star2->GetMass();
         });
+
+        char Rank = 'A';
+        for (auto& Star : Stars)
+        {
+            Star->SetName(std::string(FormatName("STAR-{:08} {}", DistanceRank, Rank)));
+            ++Rank;
+        }
     }
+    else
+    {
+        Stars.front()->SetName(std::string(FormatName("STAR-{:08}", DistanceRank)));
+    }
+}
 
-    BasicProperties.clear();
+void FUniverse::ResetHomeStellarSystem(Astro::FStellarSystem& System) const
+{
+    System.SetBaryNormal(glm::vec2(0.0f));
 
-    std::vector<Astro::AStar> Stars;
-    for (auto& Future : ChunkFutures)
+    for (auto& Star : System.StarsData())
     {
-        auto Chunk = Future.get();
-        Stars.append_range(Chunk | std::views::as_rvalue);
+        Star->SetNormal(glm::vec3(0.0f));
     }
-
-    return Stars;
 }
 
 void FUniverse::GenerateSlots(float MinDistance, std::size_t SampleCount, float Density)
@@ -852,8 +867,38 @@ void FUniverse::GenerateSlots(float MinDistance, std::size_t SampleCount, float
     float LeafRadius = LeafSize * 0.5f;
     float RootRadius = LeafSize * static_cast<float>(std::pow(2, Exponent));
 
-    _Octree = std::make_unique<System::Spatial::TOctree<Astro::FStellarSystem>>(glm::vec3(0.0), RootRadius);
-    _Octree->BuildEmptyTree(LeafRadius); // 快速构建一个空树，每个叶子节点作为一个格子，用于生成恒星
+    // 每次都从构造时的引擎状态开始，取消后重新生成或多次生成得到的都是同一个宇宙
+    _RandomEngine = _InitialRandomEngine;
+    BeginGenerationPhase(FGenerationToken::EPhase::kSlots, SampleCount);
+    CheckCancellation();
+
+    // 树的结构只取决于恒星数和密度。已有结构相同的树（例如多种子生成时上一个种子留下的）时清空后复用，
+    // 遍历顺序不变，生成结果与新建的树相同
+    auto IsOctreeReusable = [&]() -> bool
+    {
+        if (_Octree == nullptr || _Octree->GetRoot()->GetRadius() != RootRadius)
+        {
+            return false;
+        }
+
+        const FNodeType* Node = _Octree->GetRoot();
+        while (!Node->IsLeafNode())
+        {
+            Node = _Octree->GetNext(*Node, 0);
+        }
+
+        return Node->GetRadius() == LeafRadius;
+    };
+
+    if (IsOctreeReusable())
+    {
+        _Octree->ClearStorage();
+    }
+    else
+    {
+        _Octree = std::make_unique<System::Spatial::TOctree<Astro::FStellarSystem>>(glm::vec3(0.0), RootRadius);
+        _Octree->BuildEmptyTree(LeafRadius); // 快速构建一个空树，每个叶子节点作为一个格子，用于生成恒星
+    }
 
     // 遍历八叉树，将距离原点大于半径的叶子节点标记为无效，保证恒星只会在范围内生成
     _Octree->Traverse([Radius](FNodeType& Node) -> void
@@ -878,6 +923,7 @@ void FUniverse::GenerateSlots(float MinDistance, std::size_t SampleCount, float
     // 使用栅格采样，八叉树的每个叶子节点作为一个格子，在这个格子中生成一个恒星
     while (ValidLeafCount != SampleCount)
     {
+        CheckCancellation();
         LeafNodes.clear();
         _Octree->Traverse(CollectLeafNodes);
         std::shuffle(LeafNodes.begin(), LeafNodes.end(), _RandomEngine); // 打乱叶子节点，保证随机性
@@ -917,125 +963,219 @@ void FUniverse::GenerateSlots(float MinDistance, std::size_t SampleCount, float
         }
     }
 
+    CheckCancellation();
+
+    // 为了保证恒星系统的唯一性，将原点附近所在的叶子节点作为存储初始恒星系统的结点
+    // 寻找包含了 (LeafRadius, LeafRadius, LeafRadius) 的叶子节点，将这个格子存储的位置修改为原点
+    const FNodeType* HomeNode = _Octree->FindLeaf(glm::vec3(LeafRadius));
+
     Util::TUniformRealDistribution Offset(-LeafRadius, LeafRadius - MinDistance); // 用于随机生成恒星位置相对于叶子节点中心点的偏移量
-    // 遍历八叉树，为每个有效的叶子节点生成一个恒星
-    _Octree->Traverse([&Offset, LeafRadius, MinDistance, this](FNodeType& Node) -> void
+    // 按 Morton 顺序为每个有效的叶子节点生成一个恒星，位置点连续存放
+    // 初始恒星系统所在的格子同样抽取偏移量，随机数的消耗与格子的位置无关
+    _Octree->BuildStorage([&](const FNodeType& Node, std::vector<glm::vec3>& Points) -> void
     {
-        if (Node.IsLeafNode() && Node.GetValidation())
+        glm::vec3 StellarSlot(0.0f);
+        if (Node.GetValidation())
         {
             glm::vec3 Center(Node.GetCenter());
-            glm::vec3 StellarSlot(Center.x + Offset(_RandomEngine),
-                                  Center.y + Offset(_RandomEngine),
-                                  Center.z + Offset(_RandomEngine));
-            Node.AddPoint(StellarSlot);
+            StellarSlot = glm::vec3(Center.x + Offset(_RandomEngine),
+                                    Center.y + Offset(_RandomEngine),
+                                    Center.z + Offset(_RandomEngine));
         }
-    });
 
-    // 为了保证恒星系统的唯一性，将原点附近所在的叶子节点作为存储初始恒星系统的结点
-    // 寻找包含了 (LeafRadius, LeafRadius, LeafRadius) 的叶子节点，将这个格子存储的位置修改为原点
-    FNodeType* HomeNode = _Octree->Find(glm::vec3(LeafRadius), [](const FNodeType& Node) -> bool
-    {
-        return Node.IsLeafNode();
+        if (&Node == HomeNode)
+        {
+            Points.push_back(glm::vec3(0.0f));
+        }
+        else if (Node.GetValidation())
+        {
+            Points.push_back(StellarSlot);
+        }
     });
 
-    // 把最靠近原点的格子存储旧的位置点删除，加入初始恒星系统
-    HomeNode->RemoveStorage();
-    HomeNode->AddPoint(glm::vec3(0.0f));
+    if (_GenerationToken != nullptr)
+    {
+        _GenerationToken->SetProgress(SampleCount);
+    }
 }
 
-void FUniverse::OctreeLinkToStellarSystems(std::vector<Astro::AStar>& Stars, std::vector<glm::vec3>& Slots)
+std::vector<FUniverse::FNodeType*> FUniverse::CollectStellarSlots(int MaxThread)
 {
-    std::size_t Index = 0;
+    BeginGenerationPhase(FGenerationToken::EPhase::kSlotCollection, _StarCount);
+    CheckCancellation();
+
+    std::vector<glm::vec3>  Positions;
+    std::vector<FNodeType*> Nodes;
+    Positions.reserve(_StarCount);
+    Nodes.reserve(_StarCount);
 
-    _Octree->Traverse([&](FNodeType& Node) -> void
+    _Octree->Traverse([this, &Positions, &Nodes](FNodeType& Node) -> void
     {
         if (Node.IsLeafNode() && Node.GetValidation())
         {
-            for (const auto& Point : Node.GetPoints())
+            for (const auto& Point : _Octree->GetPoints(Node))
             {
-                Astro::FBaryCenter NewBary(Point, glm::vec2(0.0f), 0, "");
-                Astro::FStellarSystem NewSystem(NewBary);
-                NewSystem.StarsData().push_back(std::make_unique<Astro::AStar>(Stars.back()));
-                NewSystem.SetBaryNormal(NewSystem.StarsData().front()->GetNormal());
-                Stars.pop_back();
-
-                _StellarSystems.push_back(std::move(NewSystem));
-
-                Node.AddLink(&_StellarSystems[Index]);
-                Slots.push_back(Point);
-                ++Index;
+                Positions.push_back(Point);
+                Nodes.push_back(&Node);
             }
         }
     });
-}
 
-void FUniverse::GenerateBinaryStars(int MaxThread)
-{
-    std::vector<SysGen::FStellarGenerator> Generators;
-    for (int i = 0; i != MaxThread; ++i)
+    // 排序键只计算一次，使用距离的平方。非负浮点数的位模式和数值大小顺序一致，可以直接作为无符号整数做基数排序
+    std::size_t SlotCount = Positions.size();
+    std::vector<std::uint32_t> Keys(SlotCount);
+    std::vector<std::size_t>   Order(SlotCount);
+    Runtime::Thread::ForEachThreadRange(_ThreadPool, MaxThread, SlotCount, [&](int, std::size_t Begin, std::size_t End) -> void
     {
-        std::vector<std::uint32_t> Seeds(32);
-        for (int i = 0; i != 32; ++i)
+        for (std::size_t i = Begin; i != End; ++i)
         {
-            Seeds[i] = _SeedGenerator(_RandomEngine);
+            Keys[i]  = std::bit_cast<std::uint32_t>(glm::dot(Positions[i], Positions[i]));
+            Order[i] = i;
         }
+    });
 
-        std::shuffle(Seeds.begin(), Seeds.end(), _RandomEngine);
-        std::seed_seq SeedSequence(Seeds.begin(), Seeds.end());
-
-        SysGen::FStellarGenerator::FStellarGenerationInfo GenerationInfo
-        {
-            .SeedSequence       = &SeedSequence,
-            .StellarTypeOption  = SysGen::FStellarGenerator::EStellarTypeGenerationOption::kRandom,
-            .MultiplicityOption = SysGen::FStellarGenerator::EMultiplicityGenerationOption::kBinarySecondStar
-        };
+    // 按到原点的距离排序，格子和恒星系统都直接按距离排名存放，排名即下标
+    CheckCancellation();
+    ParallelRadixSort(_ThreadPool, MaxThread, Keys, Order);
+    CheckCancellation();
+
+    // 特殊星按数量填入格子类型后打乱，保证特殊星随机分布在各处
+    std::vector<EStellarSlotType> Types;
+    Types.reserve(SlotCount);
+    Types.insert(Types.end(), _ExtraGiantCount,       EStellarSlotType::kExtraGiant);
+    Types.insert(Types.end(), _ExtraMassiveStarCount, EStellarSlotType::kExtraMassiveStar);
+    Types.insert(Types.end(), _ExtraNeutronStarCount, EStellarSlotType::kExtraNeutronStar);
+    Types.insert(Types.end(), _ExtraBlackHoleCount,   EStellarSlotType::kExtraBlackHole);
+    Types.insert(Types.end(), _ExtraMergeStarCount,   EStellarSlotType::kExtraMergeStar);
+    Types.resize(SlotCount, EStellarSlotType::kCommonStar);
+    std::shuffle(Types.begin(), Types.end(), _RandomEngine);
+
+    // 种子按排名顺序从主随机数引擎中抽取，这一步必须串行
+    std::vector<FNodeType*> SlotNodes(SlotCount);
+    _StellarSlots.clear();
+    _StellarSlots.reserve(SlotCount);
+    for (std::size_t i = 0; i != SlotCount; ++i)
+    {
+        _StellarSlots.push_back({ Positions[Order[i]], _SeedGenerator(_RandomEngine), Types[i] });
+        SlotNodes[i] = Nodes[Order[i]];
+    }
 
-        Generators.push_back(GenerationInfo);
+    if (_GenerationToken != nullptr)
+    {
+        _GenerationToken->SetProgress(SlotCount);
     }
 
-    std::vector<Astro::FStellarSystem*> BinarySystems;
-    for (auto& System : _StellarSystems)
+    return SlotNodes;
+}
+
+void FUniverse::OctreeLinkToStellarSystems(const std::vector<FNodeType*>& SlotNodes)
+{
+    constexpr std::size_t kProgressInterval = 1 << 16;
+
+    BeginGenerationPhase(FGenerationToken::EPhase::kLinking, _StellarSlots.size());
+
+    _StellarSystems.clear();
+    _StellarSystems.reserve(_StellarSlots.size());
+    for (std::size_t i = 0; i != _StellarSlots.size(); ++i)
     {
-        const auto& Star = System.StarsData().front();
-        if (!Star->GetIsSingleStar())
+        if (i % kProgressInterval == 0 && _GenerationToken != nullptr)
         {
-            BinarySystems.push_back(&System);
+            _GenerationToken->SetProgress(i);
+            CheckCancellation();
         }
+
+        Astro::FBaryCenter NewBary(_StellarSlots[i].Position, glm::vec2(0.0f), i, "");
+        _StellarSystems.emplace_back(NewBary);
+        _Octree->AddLink(*SlotNodes[i], &_StellarSystems.back());
     }
+}
+
+SysGen::FStellarGenerator::FBasicProperties
+FUniverse::GenerateSlotProperties(std::size_t DistanceRank, FSystemGenerators& Generators) const
+{
+    const auto& Slot = _StellarSlots[DistanceRank];
+    auto& Generator  = Generators.StellarGenerators[std::to_underlying(Slot.Type)];
+
+    Generator.Reseed(MakeSlotSeedSequence(Slot.Seed, DistanceRank, std::to_underlying(ESlotStream::kPrimaryProperties)));
+    return Generator.GenerateBasicProperties();
+}
+
+SysGen::FStellarGenerator::FBasicProperties
+FUniverse::GenerateSlotCompanionProperties(std::size_t DistanceRank, const Astro::AStar& FirstStar,
+                                           SysGen::FStellarGenerator& Generator) const
+{
+    const auto& Slot = _StellarSlots[DistanceRank];
 
-    std::vector<SysGen::FStellarGenerator::FBasicProperties> BasicProperties;
-    for (std::size_t i = 0; i != BinarySystems.size(); ++i)
+    float FirstStarInitialMassSol = FirstStar.GetInitialMass() / kSolarMass;
+    float MassLowerLimit          = std::max(0.075f, 0.1f * FirstStarInitialMassSol);
+    float MassUpperLimit          = std::min(10 * FirstStarInitialMassSol, 300.0f);
+
+    Generator.SetMassLowerLimit(MassLowerLimit);
+    Generator.SetMassUpperLimit(MassUpperLimit);
+    Generator.SetLogMassSuggestNormal(std::log10(FirstStarInitialMassSol), 0.25f);
+
+    double Age = FirstStar.GetAge();
+    float  FeH = FirstStar.GetFeH();
+
+    if (std::to_underlying(FirstStar.GetEvolutionPhase()) > 10)
     {
-        std::size_t ThreadId    = i % MaxThread;
-        auto& SelectedGenerator = Generators[ThreadId];
+        Age -= FirstStar.GetLifetime();
+    }
 
-        const auto& Star              = BinarySystems[i]->StarsData().front();
-        float FirstStarInitialMassSol = Star->GetInitialMass() / kSolarMass;
-        float MassLowerLimit          = std::max(0.075f, 0.1f * FirstStarInitialMassSol);
-        float MassUpperLimit          = std::min(10 * FirstStarInitialMassSol, 300.0f);
+    Generator.Reseed(MakeSlotSeedSequence(Slot.Seed, DistanceRank, std::to_underlying(ESlotStream::kCompanionProperties)));
+    return Generator.GenerateBasicProperties(static_cast<float>(Age), FeH);
+}
 
-        SelectedGenerator.SetMassLowerLimit(MassLowerLimit);
-        SelectedGenerator.SetMassUpperLimit(MassUpperLimit);
-        SelectedGenerator.SetLogMassSuggestDistribution(
-            std::make_unique<Util::TNormalDistribution<>>(std::log10(FirstStarInitialMassSol), 0.25f));
+Astro::AStar FUniverse::GenerateSlotStar(std::size_t DistanceRank, ESlotStream Stream,
+                                         SysGen::FStellarGenerator::FBasicProperties& Properties,
+                                         SysGen::FStellarGenerator& Generator) const
+{
+    const auto& Slot = _StellarSlots[DistanceRank];
 
-        double Age = Star->GetAge();
-        float  FeH = Star->GetFeH();
+    Generator.Reseed(MakeSlotSeedSequence(Slot.Seed, DistanceRank, std::to_underlying(Stream)));
+    return Generator.GenerateStar(Properties);
+}
 
-        if (std::to_underlying(Star->GetEvolutionPhase()) > 10)
-        {
-            Age -= Star->GetLifetime();
-        }
+void FUniverse::GenerateSlotOrbitals(std::size_t DistanceRank, SysGen::FOrbitalGenerator& Generator,
+                                     Astro::FStellarSystem& System) const
+{
+    const auto& Slot = _StellarSlots[DistanceRank];
+
+    Generator.Reseed(MakeSlotSeedSequence(Slot.Seed, DistanceRank, std::to_underlying(ESlotStream::kOrbitals)));
+    Generator.GenerateOrbitals(System);
+}
 
-        BasicProperties.push_back(SelectedGenerator.GenerateBasicProperties(static_cast<float>(Age), FeH));
+void FUniverse::MaterializeStellarSystem(std::size_t DistanceRank, FSystemGenerators& Generators,
+                                         Astro::FStellarSystem& System) const
+{
+    // 依次完成单个格子的全部生成步骤，系统直接在最终的存储位置上生成
+    auto& Interpolator = Generators.StellarGenerators[std::to_underlying(EStellarSlotType::kCommonStar)];
+
+    System = Astro::FStellarSystem(Astro::FBaryCenter(_StellarSlots[DistanceRank].Position, glm::vec2(0.0f), DistanceRank, ""));
+
+    // 恒星在生成器中只构造一次，之后移动到堆上的最终位置，不经过中间数组，也不发生复制
+    auto Properties = GenerateSlotProperties(DistanceRank, Generators);
+    System.StarsData().reserve(2);
+    System.StarsData().push_back(
+        std::make_unique<Astro::AStar>(GenerateSlotStar(DistanceRank, ESlotStream::kPrimaryStar, Properties, Interpolator)));
+    System.SetBaryNormal(System.StarsData().front()->GetNormal());
+
+    const Astro::AStar& FirstStar = *System.StarsData().front();
+    if (!FirstStar.GetIsSingleStar())
+    {
+        auto CompanionProperties = GenerateSlotCompanionProperties(DistanceRank, FirstStar, Generators.CompanionGenerator);
+        System.StarsData().push_back(std::make_unique<Astro::AStar>(
+            GenerateSlotStar(DistanceRank, ESlotStream::kCompanionStar, CompanionProperties, Interpolator)));
     }
 
-    std::vector<Astro::AStar> Stars = InterpolateStars(MaxThread, Generators, BasicProperties);
+    AssignName(System);
 
-    for (std::size_t i = 0; i != BinarySystems.size(); ++i)
+    if (DistanceRank == 0)
     {
-        BinarySystems[i]->StarsData().push_back(std::make_unique<Astro::AStar>(Stars[i]));
+        ResetHomeStellarSystem(System);
     }
+
+    GenerateSlotOrbitals(DistanceRank, Generators.OrbitalGenerator, System);
 }
 
 _NPGS_END
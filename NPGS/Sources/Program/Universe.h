@@ -1,57 +1,197 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <random>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "Engine/Core/Base/Base.h"
+#include "Engine/Core/System/Generators/OrbitalGenerator.h"
 #include "Engine/Core/System/Generators/StellarGenerator.h"
 #include "Engine/Core/System/Spatial/Octree.hpp"
 #include "Engine/Core/Runtime/Threads/ThreadPool.h"
 #include "Engine/Core/Types/Entries/Astro/Star.h"
 #include "Engine/Core/Types/Entries/Astro/StellarSystem.h"
 #include "Engine/Utils/Random.hpp"
+#include "GenerationToken.h"
+#include "StellarStatistics.h"
 
 _NPGS_BEGIN
 
 class FUniverse
 {
+    friend class FUniverseBenchmark;
+    friend class FUniverseEnsemble;
+    friend class FUniverseShard;
+
+public:
+    using FNodeType = System::Spatial::TOctree<Astro::FStellarSystem>::FNodeType;
+
+    // 恒星在星表中的位置，StarIndex 为按质量降序排列的成员下标，与名字的后缀 A, B, ... 对应
+    struct FStarLocation
+    {
+        std::size_t DistanceRank{};
+        std::size_t StarIndex{};
+    };
+
 public:
     FUniverse() = delete;
     FUniverse(std::uint32_t Seed, std::size_t StarCount, std::size_t ExtraGiantCount = 0, std::size_t ExtraMassiveStarCount = 0,
               std::size_t ExtraNeutronStarCount = 0, std::size_t ExtraBlackHoleCount = 0, std::size_t ExtraMergeStarCount   = 0,
               float UniverseAge = 1.38e10f);
 
-    ~FUniverse() = default;
+    ~FUniverse();
 
     void FillUniverse();
-    void ReplaceStar(std::size_t DistanceRank, const Astro::AStar& StarData);
-    void CountStars();
+    void FillUniverseProgressive(std::size_t NearFieldSystemCount = 4096, const glm::vec3& FocusPosition = glm::vec3(0.0f));
+    void FillUniverseOnDemand();
+    // 等待后台生成结束，后台生成中除取消以外的异常在这里重新抛出
+    void WaitForCompletion();
+    bool ReplaceStar(std::size_t DistanceRank, const Astro::AStar& StarData);
+    bool ReplaceStar(std::size_t DistanceRank, std::size_t StarIndex, const Astro::AStar& StarData);
+    bool ReplaceStar(std::string_view StarName, const Astro::AStar& StarData);
+    // 统计全部恒星系统。按需模式下只统计当前常驻内存的恒星系统，结果中的极值恒星为副本
+    FStellarStatistics::FResult CountStars();
+    FStellarStatistics& GetStatistics();
+
+    // 生成函数在各阶段报告进度并检查取消，取消时抛出 FGenerationCancelled。取消后再次调用 FillUniverse
+    // 或 FillUniverseProgressive（焦点相同）时，从已完成的恒星系统继续生成
+    void SetGenerationToken(std::shared_ptr<FGenerationToken> Token);
+
+    Astro::FStellarSystem* GetStellarSystem(std::size_t DistanceRank);
+    Astro::AStar* GetStar(std::string_view StarName);
+    std::optional<FStarLocation> FindStar(std::string_view StarName) const;
+    std::span<Astro::FStellarSystem* const> GetLeafStellarSystems(const FNodeType& LeafNode) const;
+
+    // 八叉树的位置点链接到恒星系统，用于半径、最近邻和视锥查询。按需生成时位置点没有链接
+    const System::Spatial::TOctree<Astro::FStellarSystem>* GetOctree() const;
+    // 用已经生成的恒星系统的总光度（太阳光度）计算八叉树的聚合数据，供带细节层次的视锥查询使用，尚未生成的系统按 0 计
+    // FillUniverse 和 WaitForCompletion 在全部系统生成完成后自动调用，替换恒星后需要重新调用
+    void UpdateOctreeAggregates();
+    void ReleaseStellarSystem(std::size_t DistanceRank);
+
+    bool IsStellarSystemReady(std::size_t DistanceRank) const;
+    std::size_t GetReadySystemCount() const;
+    std::size_t GetMaterializedSystemCount() const;
+    std::size_t GetSlotCount() const;
 
 private:
-    void GenerateStars(int MaxThread);
-    void FillStellarSystem(int MaxThread);
+    // 格子类型，决定主星基础属性使用哪一组生成参数
+    enum class EStellarSlotType : std::uint8_t
+    {
+        kCommonStar,
+        kExtraGiant,
+        kExtraMassiveStar,
+        kExtraNeutronStar,
+        kExtraBlackHole,
+        kExtraMergeStar
+    };
+
+    // 同一个格子的各个生成步骤使用互相独立的随机数流，与生成顺序和线程数无关
+    enum class ESlotStream : std::uint32_t
+    {
+        kPrimaryProperties,
+        kPrimaryStar,
+        kCompanionProperties,
+        kCompanionStar,
+        kOrbitals
+    };
+
+    // 格子只保存位置和种子，恒星系统的全部内容都可以由这两者重新生成
+    struct FStellarSlot
+    {
+        glm::vec3        Position{};
+        std::uint32_t    Seed{};
+        EStellarSlotType Type{ EStellarSlotType::kCommonStar };
+    };
+
+    // 一组完整的生成器，每个在途的块独占一组，使用前按格子重新播种
+    struct FSystemGenerators
+    {
+        FSystemGenerators(const std::seed_seq& SeedSequence, float UniverseAge);
 
-    std::vector<Astro::AStar> InterpolateStars(int MaxThread, std::vector<System::Generator::FStellarGenerator>& Generators,
-                                               std::vector<System::Generator::FStellarGenerator::FBasicProperties>& BasicProperties);
+        std::vector<System::Generator::FStellarGenerator> StellarGenerators; // 按 EStellarSlotType 索引
+        System::Generator::FStellarGenerator              CompanionGenerator;
+        System::Generator::FOrbitalGenerator              OrbitalGenerator;
+    };
+
+private:
+    bool CanResumeGeneration(const glm::vec3& FocusPosition) const;
+    void CheckCancellation() const;
+    void BeginGenerationPhase(FGenerationToken::EPhase Phase, std::size_t Total) const;
+    void PrepareStellarSystems(int MaxThread, const glm::vec3& FocusPosition);
+    void BuildGenerationOrder(const glm::vec3& FocusPosition);
+    void GenerateStellarSystems(int MaxThread, std::size_t BeginIndex, std::size_t EndIndex);
+    void CreateSystemGenerators(int GeneratorCount);
+    void AssignName(Astro::FStellarSystem& System) const;
+    void ResetHomeStellarSystem(Astro::FStellarSystem& System) const;
 
     void GenerateSlots(float MinDistance, std::size_t SampleCount, float Density);
-    void OctreeLinkToStellarSystems(std::vector<Astro::AStar>& Stars, std::vector<glm::vec3>& Slots);
-    void GenerateBinaryStars(int MaxThread);
+    std::vector<FNodeType*> CollectStellarSlots(int MaxThread);
+    void OctreeLinkToStellarSystems(const std::vector<FNodeType*>& SlotNodes);
+
+    // 单个格子的生成步骤，分块生成和按需生成共用，保证两者结果一致
+    System::Generator::FStellarGenerator::FBasicProperties
+    GenerateSlotProperties(std::size_t DistanceRank, FSystemGenerators& Generators) const;
+
+    System::Generator::FStellarGenerator::FBasicProperties
+    GenerateSlotCompanionProperties(std::size_t DistanceRank, const Astro::AStar& FirstStar,
+                                    System::Generator::FStellarGenerator& Generator) const;
+
+    Astro::AStar GenerateSlotStar(std::size_t DistanceRank, ESlotStream Stream,
+                                  System::Generator::FStellarGenerator::FBasicProperties& Properties,
+                                  System::Generator::FStellarGenerator& Generator) const;
+
+    void GenerateSlotOrbitals(std::size_t DistanceRank, System::Generator::FOrbitalGenerator& Generator,
+                              Astro::FStellarSystem& System) const;
+
+    void MaterializeStellarSystem(std::size_t DistanceRank, FSystemGenerators& Generators, Astro::FStellarSystem& System) const;
 
 private:
-    using FNodeType = System::Spatial::TOctree<Astro::FStellarSystem>::FNodeType;
+    static constexpr std::size_t _kStellarSlotTypeCount    = 6;
+    static constexpr std::size_t _kSystemChunkSize         = 256;
+    static constexpr int         _kInFlightChunksPerThread = 2;
 
 private:
-    std::mt19937                                                     _RandomEngine;
-    std::vector<Astro::FStellarSystem>                               _StellarSystems;
-    Util::TUniformIntDistribution<std::uint32_t>                     _SeedGenerator;
-    Util::TUniformRealDistribution<>                                 _CommonGenerator;
-    std::unique_ptr<System::Spatial::TOctree<Astro::FStellarSystem>> _Octree;
-    Runtime::Thread::FThreadPool*                                    _ThreadPool;
+    std::mt19937                                                        _RandomEngine;
+    std::mt19937                                                        _InitialRandomEngine; // 每次生成格子前恢复，重复生成得到同一个宇宙
+    std::vector<Astro::FStellarSystem>                                  _StellarSystems;
+    Util::TUniformIntDistribution<std::uint32_t>                        _SeedGenerator;
+    Util::TUniformRealDistribution<>                                    _CommonGenerator;
+    std::unique_ptr<System::Spatial::TOctree<Astro::FStellarSystem>>    _Octree;
+    Runtime::Thread::FThreadPool*                                       _ThreadPool;
+
+    // 格子按距离排名存储，排名即下标
+    std::vector<FStellarSlot>                                           _StellarSlots;
+    std::vector<FSystemGenerators>                                      _SystemGenerators;
+
+    // 渐进式生成状态，_StellarSystems 按距离排名存储，_GenerationOrder 为生成顺序，按到焦点的距离排序
+    std::vector<std::size_t>                                            _GenerationOrder;
+    std::vector<std::size_t>                                            _GenerationIndices;
+    std::atomic<std::size_t>                                            _ReadySystemCount;
+    std::thread                                                         _GenerationThread;
+    std::exception_ptr                                                  _GenerationException; // 后台生成中抛出的异常，汇合时重新抛出
+    glm::vec3                                                           _GenerationFocus;
+    bool                                                                _bPrepared;           // 格子、生成顺序和生成器均已就绪
+    std::shared_ptr<FGenerationToken>                                   _GenerationToken;
+
+    // 按需生成状态，只有被访问过且未释放的恒星系统常驻内存
+    std::unordered_map<std::size_t, std::unique_ptr<Astro::FStellarSystem>> _MaterializedSystems;
+    mutable std::mutex                                                  _MaterializationMutex;
+    bool                                                                _bOnDemand;
+
+    FStellarStatistics                                                  _Statistics;
 
     std::size_t _StarCount;
     std::size_t _ExtraGiantCount;
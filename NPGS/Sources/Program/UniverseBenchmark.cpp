@@ -0,0 +1,301 @@
+#include "UniverseBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <sstream>
+#include <string>
+#endif
+
+#include "Engine/Core/Runtime/Threads/Parallel.h"
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+#include "Engine/Utils/Logger.h"
+#include "Universe.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    // 返回当前和峰值的常驻内存字节数，无法读取时为 0
+    std::pair<std::size_t, std::size_t> GetProcessMemory()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS Counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+        {
+            return { 0, 0 };
+        }
+
+        return { Counters.WorkingSetSize, Counters.PeakWorkingSetSize };
+#elif defined(__linux__)
+        // VmRSS 和 VmHWM 以 kB 为单位，对应 Windows 的工作集和峰值工作集
+        std::ifstream Status("/proc/self/status");
+        std::size_t WorkingSet = 0;
+        std::size_t PeakMemory = 0;
+        std::string Line;
+        while (std::getline(Status, Line))
+        {
+            std::istringstream Stream(Line);
+            std::string Key;
+            std::size_t Kilobytes = 0;
+            if (!(Stream >> Key >> Kilobytes))
+            {
+                continue;
+            }
+
+            if (Key == "VmRSS:")
+            {
+                WorkingSet = Kilobytes * 1024;
+            }
+            else if (Key == "VmHWM:")
+            {
+                PeakMemory = Kilobytes * 1024;
+            }
+        }
+
+        return { WorkingSet, PeakMemory };
+#else
+        return { 0, 0 };
+#endif
+    }
+}
+
+// UniverseBenchmark implementations
+// ---------------------------------
+FUniverseBenchmark::FUniverseBenchmark(const FBenchmarkInfo& Info)
+    : _Info(Info)
+{
+}
+
+FUniverseBenchmark::FResult FUniverseBenchmark::Run() const
+{
+    using ESlotStream      = FUniverse::ESlotStream;
+    using EStellarSlotType = FUniverse::EStellarSlotType;
+
+    auto* ThreadPool = Runtime::Thread::FThreadPool::GetInstance();
+    int MaxThread = ThreadPool->GetMaxThreadCount();
+    if (_Info.ThreadCount > 0)
+    {
+        MaxThread = std::min(_Info.ThreadCount, MaxThread);
+    }
+
+    FResult Result;
+    Result.Info        = _Info;
+    Result.ThreadCount = MaxThread;
+
+    bool bTelemetryEnabled = ThreadPool->IsTelemetryEnabled();
+    ThreadPool->ResetTelemetry();
+    ThreadPool->SetTelemetryEnabled(true);
+
+    auto Universe = std::make_unique<FUniverse>(_Info.Seed, _Info.StarCount, _Info.ExtraGiantCount, _Info.ExtraMassiveStarCount,
+                                                _Info.ExtraNeutronStarCount, _Info.ExtraBlackHoleCount, _Info.ExtraMergeStarCount,
+                                                _Info.UniverseAge);
+
+    // Phase 返回本阶段处理的恒星或格子数
+    auto Measure = [&](const char* Name, auto&& Phase) -> void
+    {
+        NpgsCoreInfo("Benchmark phase: {}...", Name);
+
+        auto BeginTime = std::chrono::steady_clock::now();
+        std::size_t ItemCount = Phase();
+        std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - BeginTime;
+
+        auto [WorkingSet, PeakMemory] = GetProcessMemory();
+
+        FPhaseResult PhaseResult
+        {
+            .Name            = Name,
+            .WallSeconds     = Elapsed.count(),
+            .ItemCount       = ItemCount,
+            .ItemsPerSecond  = Elapsed.count() > 0.0 ? ItemCount / Elapsed.count() : 0.0,
+            .WorkingSetBytes = WorkingSet,
+            .PeakMemoryBytes = PeakMemory
+        };
+
+        Result.TotalSeconds += PhaseResult.WallSeconds;
+        Result.Phases.push_back(std::move(PhaseResult));
+    };
+
+    // 每颗恒星的耗时差异很大，用动态分块的 ParallelFor 均衡负载，ThreadId 用于选择线程独占的生成器
+    auto ForEachSystem = [&](auto&& Pred) -> void
+    {
+        Runtime::Thread::ParallelFor(ThreadPool, MaxThread, Universe->_StellarSlots.size(),
+        [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+        {
+            auto& Generators = Universe->_SystemGenerators[ThreadId];
+            for (std::size_t DistanceRank = Begin; DistanceRank != End; ++DistanceRank)
+            {
+                Pred(DistanceRank, Generators, Universe->_StellarSystems[DistanceRank]);
+            }
+        }, _kMinChunkSize);
+    };
+
+    std::vector<FUniverse::FNodeType*> SlotNodes;
+    Measure("slot_generation", [&]() -> std::size_t
+    {
+        Universe->GenerateSlots(0.1f, _Info.StarCount, 0.004f);
+        SlotNodes = Universe->CollectStellarSlots(MaxThread);
+        return Universe->_StellarSlots.size();
+    });
+
+    Measure("octree_linking", [&]() -> std::size_t
+    {
+        Universe->OctreeLinkToStellarSystems(SlotNodes);
+        return SlotNodes.size();
+    });
+
+    // 生成器的构造不属于任何阶段，不计时
+    Universe->CreateSystemGenerators(MaxThread);
+
+    std::size_t SystemCount = Universe->_StellarSlots.size();
+    std::vector<System::Generator::FStellarGenerator::FBasicProperties> BasicProperties(SystemCount);
+    Measure("basic_properties", [&]() -> std::size_t
+    {
+        ForEachSystem([&](std::size_t DistanceRank, FUniverse::FSystemGenerators& Generators, Astro::FStellarSystem&) -> void
+        {
+            BasicProperties[DistanceRank] = Universe->GenerateSlotProperties(DistanceRank, Generators);
+        });
+
+        return SystemCount;
+    });
+
+    Measure("mist_interpolation", [&]() -> std::size_t
+    {
+        ForEachSystem([&](std::size_t DistanceRank, FUniverse::FSystemGenerators& Generators, Astro::FStellarSystem& System) -> void
+        {
+            auto& Interpolator = Generators.StellarGenerators[std::to_underlying(EStellarSlotType::kCommonStar)];
+            System.StarsData().reserve(2);
+            System.StarsData().push_back(std::make_unique<Astro::AStar>(
+                Universe->GenerateSlotStar(DistanceRank, ESlotStream::kPrimaryStar, BasicProperties[DistanceRank], Interpolator)));
+            System.SetBaryNormal(System.StarsData().front()->GetNormal());
+        });
+
+        return SystemCount;
+    });
+
+    BasicProperties.clear();
+    BasicProperties.shrink_to_fit();
+
+    std::vector<std::size_t> CompanionCounts(MaxThread);
+    Measure("binaries", [&]() -> std::size_t
+    {
+        Runtime::Thread::ParallelFor(ThreadPool, MaxThread, SystemCount,
+        [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+        {
+            auto& Generators   = Universe->_SystemGenerators[ThreadId];
+            auto& Interpolator = Generators.StellarGenerators[std::to_underlying(EStellarSlotType::kCommonStar)];
+            for (std::size_t DistanceRank = Begin; DistanceRank != End; ++DistanceRank)
+            {
+                auto& System = Universe->_StellarSystems[DistanceRank];
+                const Astro::AStar& FirstStar = *System.StarsData().front();
+                if (FirstStar.GetIsSingleStar())
+                {
+                    continue;
+                }
+
+                auto CompanionProperties =
+                    Universe->GenerateSlotCompanionProperties(DistanceRank, FirstStar, Generators.CompanionGenerator);
+                System.StarsData().push_back(std::make_unique<Astro::AStar>(Universe->GenerateSlotStar(
+                    DistanceRank, ESlotStream::kCompanionStar, CompanionProperties, Interpolator)));
+                ++CompanionCounts[ThreadId];
+            }
+        }, _kMinChunkSize);
+
+        return std::accumulate(CompanionCounts.begin(), CompanionCounts.end(), static_cast<std::size_t>(0));
+    });
+
+    Measure("naming", [&]() -> std::size_t
+    {
+        ForEachSystem([&](std::size_t DistanceRank, FUniverse::FSystemGenerators&, Astro::FStellarSystem& System) -> void
+        {
+            Universe->AssignName(System);
+            if (DistanceRank == 0)
+            {
+                Universe->ResetHomeStellarSystem(System);
+            }
+        });
+
+        return SystemCount;
+    });
+
+    Measure("orbital_generation", [&]() -> std::size_t
+    {
+        ForEachSystem([&](std::size_t DistanceRank, FUniverse::FSystemGenerators& Generators, Astro::FStellarSystem& System) -> void
+        {
+            Universe->GenerateSlotOrbitals(DistanceRank, Generators.OrbitalGenerator, System);
+        });
+
+        return SystemCount;
+    });
+
+    Result.SystemCount    = SystemCount;
+    Result.TotalStarCount = SystemCount + std::accumulate(CompanionCounts.begin(), CompanionCounts.end(), static_cast<std::size_t>(0));
+
+    Result.WorkerTelemetry = ThreadPool->GetTelemetry();
+    ThreadPool->SetTelemetryEnabled(bTelemetryEnabled);
+
+    NpgsCoreInfo("Benchmark completed: {} stars in {} systems, {:.3f} s.", Result.TotalStarCount, SystemCount, Result.TotalSeconds);
+    return Result;
+}
+
+nlohmann::json FUniverseBenchmark::ToJson(const FResult& Result)
+{
+    nlohmann::json Json;
+    Json["seed"]                     = Result.Info.Seed;
+    Json["star_count"]               = Result.Info.StarCount;
+    Json["extra_giant_count"]        = Result.Info.ExtraGiantCount;
+    Json["extra_massive_star_count"] = Result.Info.ExtraMassiveStarCount;
+    Json["extra_neutron_star_count"] = Result.Info.ExtraNeutronStarCount;
+    Json["extra_black_hole_count"]   = Result.Info.ExtraBlackHoleCount;
+    Json["extra_merge_star_count"]   = Result.Info.ExtraMergeStarCount;
+    Json["universe_age"]             = Result.Info.UniverseAge;
+    Json["thread_count"]             = Result.ThreadCount;
+    Json["system_count"]             = Result.SystemCount;
+    Json["total_star_count"]         = Result.TotalStarCount;
+    Json["total_seconds"]            = Result.TotalSeconds;
+
+    nlohmann::json Phases = nlohmann::json::array();
+    for (const auto& Phase : Result.Phases)
+    {
+        Phases.push_back(
+        {
+            { "name",              Phase.Name            },
+            { "wall_seconds",      Phase.WallSeconds     },
+            { "item_count",        Phase.ItemCount       },
+            { "stars_per_second",  Phase.ItemsPerSecond  },
+            { "working_set_bytes", Phase.WorkingSetBytes },
+            { "peak_memory_bytes", Phase.PeakMemoryBytes }
+        });
+    }
+
+    Json["phases"] = std::move(Phases);
+
+    nlohmann::json Workers = nlohmann::json::array();
+    for (const auto& Worker : Result.WorkerTelemetry)
+    {
+        Workers.push_back(
+        {
+            { "task_count",                   Worker.TaskCount          },
+            { "steal_count",                  Worker.StealCount         },
+            { "busy_nanoseconds",             Worker.BusyNanoseconds    },
+            { "idle_nanoseconds",             Worker.IdleNanoseconds    },
+            { "queue_wait_histogram_log2_us", Worker.QueueWaitHistogram },
+            { "run_time_histogram_log2_us",   Worker.RunTimeHistogram   }
+        });
+    }
+
+    Json["workers"] = std::move(Workers);
+    return Json;
+}
+
+_NPGS_END
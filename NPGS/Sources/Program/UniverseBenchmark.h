@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "Engine/Core/Base/Base.h"
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+
+_NPGS_BEGIN
+
+// 按阶段测量 FUniverse 的生成耗时。各阶段依次对全部格子执行，与分块流水线生成的结果完全一致，
+// 但阶段之间互不重叠，因此可以单独计时。不依赖窗口和渲染，可以在命令行中运行
+class FUniverseBenchmark
+{
+public:
+    struct FBenchmarkInfo
+    {
+        std::uint32_t Seed{};
+        std::size_t   StarCount{};
+        std::size_t   ExtraGiantCount{};
+        std::size_t   ExtraMassiveStarCount{};
+        std::size_t   ExtraNeutronStarCount{};
+        std::size_t   ExtraBlackHoleCount{};
+        std::size_t   ExtraMergeStarCount{};
+        float         UniverseAge{ 1.38e10f };
+        int           ThreadCount{}; // 不大于 0 时使用线程池的全部线程
+    };
+
+    struct FPhaseResult
+    {
+        std::string Name;
+        double      WallSeconds{};
+        std::size_t ItemCount{};       // 本阶段处理的恒星或格子数
+        double      ItemsPerSecond{};
+        std::size_t WorkingSetBytes{}; // 阶段结束时的工作集
+        std::size_t PeakMemoryBytes{}; // 进程启动以来的峰值工作集，Linux 上为 VmHWM
+    };
+
+    struct FResult
+    {
+        FBenchmarkInfo            Info;
+        int                       ThreadCount{};
+        std::size_t               SystemCount{};
+        std::size_t               TotalStarCount{};
+        double                    TotalSeconds{};
+        std::vector<FPhaseResult> Phases;
+        std::vector<Runtime::Thread::FThreadPool::FWorkerTelemetry> WorkerTelemetry; // 整个测试期间各工作线程的统计
+    };
+
+public:
+    explicit FUniverseBenchmark(const FBenchmarkInfo& Info);
+    ~FUniverseBenchmark() = default;
+
+    FResult Run() const;
+
+    static nlohmann::json ToJson(const FResult& Result);
+
+private:
+    static constexpr std::size_t _kMinChunkSize = 16;
+
+private:
+    FBenchmarkInfo _Info;
+};
+
+_NPGS_END
@@ -0,0 +1,79 @@
+#include "UniverseEnsemble.h"
+
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+#include "Engine/Utils/Logger.h"
+#include "Universe.h"
+
+_NPGS_BEGIN
+
+FUniverseEnsemble::FUniverseEnsemble(const FEnsembleInfo& Info)
+    : _Info(Info)
+{
+}
+
+FUniverseEnsemble::FResult FUniverseEnsemble::Run(const FSeedCallback& OnSeedGenerated)
+{
+    auto* ThreadPool = Runtime::Thread::FThreadPool::GetInstance();
+
+    FResult Result;
+    Result.Aggregate = _Statistics.CreateResult();
+    Result.SeedResults.reserve(_Info.Seeds.size());
+
+    // 上一个种子留下的八叉树，结构相同，GenerateSlots 清空后直接复用
+    std::unique_ptr<System::Spatial::TOctree<Astro::FStellarSystem>> Octree;
+
+    for (std::size_t i = 0; i != _Info.Seeds.size(); ++i)
+    {
+        std::uint32_t Seed = _Info.Seeds[i];
+        NpgsCoreInfo("Ensemble: generating seed {} ({} of {})...", Seed, i + 1, _Info.Seeds.size());
+
+        auto BeginTime = std::chrono::steady_clock::now();
+
+        auto Universe = std::make_unique<FUniverse>(Seed, _Info.StarCount, _Info.ExtraGiantCount, _Info.ExtraMassiveStarCount,
+                                                    _Info.ExtraNeutronStarCount, _Info.ExtraBlackHoleCount,
+                                                    _Info.ExtraMergeStarCount, _Info.UniverseAge);
+
+        Universe->_Octree = std::move(Octree);
+        Universe->FillUniverse();
+
+        FSeedResult SeedResult
+        {
+            .Seed        = Seed,
+            .SystemCount = Universe->_StellarSystems.size(),
+            .Statistics  = _Statistics.Compute(Universe->_StellarSystems, ThreadPool, ThreadPool->GetMaxThreadCount())
+        };
+
+        if (OnSeedGenerated != nullptr)
+        {
+            OnSeedGenerated(Seed, *Universe);
+        }
+
+        FStellarStatistics::Detach(SeedResult.Statistics);
+        Octree = std::move(Universe->_Octree);
+        Universe.reset();
+
+        std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - BeginTime;
+        SeedResult.WallSeconds = Elapsed.count();
+        Result.TotalSeconds   += SeedResult.WallSeconds;
+
+        NpgsCoreInfo("Ensemble: seed {} completed, {} stars in {} systems, {:.3f} s.",
+                     Seed, SeedResult.Statistics.TotalStars, SeedResult.SystemCount, SeedResult.WallSeconds);
+
+        // 副本由 unique_ptr 持有，移动 SeedResult 之后总体统计中的指针依然有效
+        FStellarStatistics::Merge(Result.Aggregate, SeedResult.Statistics);
+        Result.SeedResults.push_back(std::move(SeedResult));
+    }
+
+    return Result;
+}
+
+FStellarStatistics& FUniverseEnsemble::GetStatistics()
+{
+    return _Statistics;
+}
+
+_NPGS_END
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+#include "StellarStatistics.h"
+
+_NPGS_BEGIN
+
+class FUniverse;
+
+// 在同一个进程中依次生成同一配置、不同种子的多个宇宙。MIST 数据和质量、年龄分布本来就由所有生成器共享，
+// 线程池只创建一次，八叉树的结构在种子之间复用。每个种子的统计结果独立保存，同时合并为总体统计
+class FUniverseEnsemble
+{
+public:
+    struct FEnsembleInfo
+    {
+        std::vector<std::uint32_t> Seeds;
+        std::size_t StarCount{};
+        std::size_t ExtraGiantCount{};
+        std::size_t ExtraMassiveStarCount{};
+        std::size_t ExtraNeutronStarCount{};
+        std::size_t ExtraBlackHoleCount{};
+        std::size_t ExtraMergeStarCount{};
+        float       UniverseAge{ 1.38e10f };
+    };
+
+    struct FSeedResult
+    {
+        std::uint32_t               Seed{};
+        std::size_t                 SystemCount{};
+        double                      WallSeconds{};
+        FStellarStatistics::FResult Statistics; // 已经 Detach，不引用已销毁的宇宙
+    };
+
+    struct FResult
+    {
+        std::vector<FSeedResult>    SeedResults;
+        FStellarStatistics::FResult Aggregate; // 所有种子的合计，极值恒星指向 SeedResults 中的副本
+        double                      TotalSeconds{};
+    };
+
+    // 每个种子生成完成、宇宙销毁之前调用，可以读取或导出这个种子的全部恒星系统
+    using FSeedCallback = std::function<void(std::uint32_t Seed, FUniverse& Universe)>;
+
+public:
+    explicit FUniverseEnsemble(const FEnsembleInfo& Info);
+    ~FUniverseEnsemble() = default;
+
+    FResult Run(const FSeedCallback& OnSeedGenerated = nullptr);
+
+    // 所有种子共用的统计引擎，自定义统计项在 Run 之前注册
+    FStellarStatistics& GetStatistics();
+
+private:
+    FEnsembleInfo      _Info;
+    FStellarStatistics _Statistics;
+};
+
+_NPGS_END
@@ -0,0 +1,357 @@
+#include "UniverseShard.h"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+#include "Engine/Core/Math/NumericConstants.h"
+#include "Engine/Core/Runtime/Threads/Parallel.h"
+#include "Engine/Core/Runtime/Threads/ThreadPool.h"
+#include "Engine/Utils/Logger.h"
+#include "Universe.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    constexpr int kShardFormatVersion = 1;
+
+    // 节点所在的扇区。从根节点向下逐层按子节点中心所在的卦限编码，与子节点的存储顺序无关
+    // Ancestors 是调用方复用的缓冲区
+    std::uint32_t GetSectorIndex(const System::Spatial::TOctree<Astro::FStellarSystem>& Octree, const FUniverse::FNodeType* Node,
+                                 int SectorDepth, std::vector<const FUniverse::FNodeType*>& Ancestors)
+    {
+        Ancestors.clear();
+        for (const auto* Current = Node; Current != nullptr; Current = Octree.GetPrevious(*Current))
+        {
+            Ancestors.push_back(Current);
+        }
+
+        if (static_cast<int>(Ancestors.size()) <= SectorDepth)
+        {
+            throw std::invalid_argument("Sector depth exceeds octree depth.");
+        }
+
+        std::uint32_t SectorIndex = 0;
+        for (int Level = 0; Level != SectorDepth; ++Level)
+        {
+            const auto* Parent = Ancestors[Ancestors.size() - 1 - Level];
+            const auto* Child  = Ancestors[Ancestors.size() - 2 - Level];
+            SectorIndex = SectorIndex * 8 + Parent->CalculateOctant(Child->GetCenter());
+        }
+
+        return SectorIndex;
+    }
+
+    nlohmann::json MakeStarJson(const Astro::AStar& Star)
+    {
+        return
+        {
+            { "name",             Star.GetName()                            },
+            { "initial_mass_sol", Star.GetInitialMass() / kSolarMass        },
+            { "mass_sol",         Star.GetMass() / kSolarMass               },
+            { "radius_sol",       Star.GetRadius() / kSolarRadius           },
+            { "luminosity_sol",   Star.GetLuminosity() / kSolarLuminosity   },
+            { "age",              Star.GetAge()                             },
+            { "feh",              Star.GetFeH()                             },
+            { "teff",             Star.GetTeff()                            },
+            { "class",            Star.GetStellarClass().ToString()         },
+            { "evolution_phase",  static_cast<int>(Star.GetEvolutionPhase()) },
+            { "lifetime",         Star.GetLifetime()                        }
+        };
+    }
+
+    // 分片的生成参数，合并时逐项比较，只有扇区序号可以不同
+    nlohmann::json MakeHeaderJson(const FUniverseShard::FShardInfo& Info, std::size_t SlotCount, std::size_t SystemCount)
+    {
+        return
+        {
+            { "format_version",           kShardFormatVersion        },
+            { "seed",                     Info.Seed                  },
+            { "star_count",               Info.StarCount             },
+            { "extra_giant_count",        Info.ExtraGiantCount       },
+            { "extra_massive_star_count", Info.ExtraMassiveStarCount },
+            { "extra_neutron_star_count", Info.ExtraNeutronStarCount },
+            { "extra_black_hole_count",   Info.ExtraBlackHoleCount   },
+            { "extra_merge_star_count",   Info.ExtraMergeStarCount   },
+            { "universe_age",             Info.UniverseAge           },
+            { "sector_depth",             Info.SectorDepth           },
+            { "sector_index",             Info.SectorIndex           },
+            { "slot_count",               SlotCount                  },
+            { "system_count",             SystemCount                }
+        };
+    }
+
+    struct FShardReader
+    {
+        std::ifstream  File;
+        nlohmann::json Header;
+        nlohmann::json Record;
+        std::string    Line;
+        std::size_t    LastRank{};
+        bool           bHasRecord{ false };
+
+        bool Next()
+        {
+            bHasRecord = false;
+            while (std::getline(File, Line))
+            {
+                if (!Line.empty())
+                {
+                    Record     = nlohmann::json::parse(Line);
+                    bHasRecord = true;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+}
+
+// UniverseShard implementations
+// -----------------------------
+FUniverseShard::FUniverseShard(const FShardInfo& Info)
+    : _Info(Info)
+{
+}
+
+std::size_t FUniverseShard::Generate() const
+{
+    if (_Info.SectorDepth < 0 || _Info.SectorDepth > _kMaxSectorDepth || _Info.SectorIndex >= GetSectorCount(_Info.SectorDepth))
+    {
+        throw std::out_of_range("Sector index out of range.");
+    }
+
+    auto* ThreadPool = Runtime::Thread::FThreadPool::GetInstance();
+    int MaxThread = ThreadPool->GetMaxThreadCount();
+
+    auto Universe = std::make_unique<FUniverse>(_Info.Seed, _Info.StarCount, _Info.ExtraGiantCount, _Info.ExtraMassiveStarCount,
+                                                _Info.ExtraNeutronStarCount, _Info.ExtraBlackHoleCount, _Info.ExtraMergeStarCount,
+                                                _Info.UniverseAge);
+
+    // 格子阶段与 FillUniverse 相同，全局的距离排名和格子种子因此与单进程生成一致
+    NpgsCoreInfo("Shard: building stellar slots for sector {} of {}...", _Info.SectorIndex, GetSectorCount(_Info.SectorDepth));
+    Universe->GenerateSlots(0.1f, Universe->_StarCount, 0.004f);
+    auto SlotNodes = Universe->CollectStellarSlots(MaxThread);
+
+    std::vector<std::size_t> SectorRanks;
+    std::vector<const FUniverse::FNodeType*> Ancestors;
+    for (std::size_t DistanceRank = 0; DistanceRank != SlotNodes.size(); ++DistanceRank)
+    {
+        if (GetSectorIndex(*Universe->_Octree, SlotNodes[DistanceRank], _Info.SectorDepth, Ancestors) == _Info.SectorIndex)
+        {
+            SectorRanks.push_back(DistanceRank);
+        }
+    }
+
+    std::ofstream File(_Info.OutputFile);
+    if (!File.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open shard file: {}", _Info.OutputFile.string()));
+    }
+
+    std::size_t SlotCount = SlotNodes.size();
+    File << MakeHeaderJson(_Info, SlotCount, SectorRanks.size()).dump() << '\n';
+
+    // 生成恒星系统只需要格子，八叉树和格子节点在这里释放，生成阶段的内存只有格子和当前批次
+    SlotNodes.clear();
+    SlotNodes.shrink_to_fit();
+    Universe->_Octree.reset();
+
+    NpgsCoreInfo("Shard: generating {} of {} stellar systems...", SectorRanks.size(), SlotCount);
+    Universe->CreateSystemGenerators(MaxThread);
+
+    // 分批生成，批内并行，写出后释放，内存占用只与批大小有关
+    std::vector<Astro::FStellarSystem> Batch;
+    for (std::size_t BatchBegin = 0; BatchBegin < SectorRanks.size(); BatchBegin += _kBatchSize)
+    {
+        std::size_t BatchSize = std::min(_kBatchSize, SectorRanks.size() - BatchBegin);
+        Batch.clear();
+        Batch.resize(BatchSize);
+
+        Runtime::Thread::ParallelFor(ThreadPool, MaxThread, BatchSize, [&](int ThreadId, std::size_t Begin, std::size_t End) -> void
+        {
+            auto& Generators = Universe->_SystemGenerators[ThreadId];
+            for (std::size_t i = Begin; i != End; ++i)
+            {
+                Universe->MaterializeStellarSystem(SectorRanks[BatchBegin + i], Generators, Batch[i]);
+            }
+        }, _kMinChunkSize);
+
+        for (std::size_t i = 0; i != BatchSize; ++i)
+        {
+            std::size_t DistanceRank = SectorRanks[BatchBegin + i];
+            const auto& Slot         = Universe->_StellarSlots[DistanceRank];
+            auto&       System       = Batch[i];
+
+            nlohmann::json Stars = nlohmann::json::array();
+            for (const auto& Star : System.StarsData())
+            {
+                Stars.push_back(MakeStarJson(*Star));
+            }
+
+            nlohmann::json Record
+            {
+                { "rank",         DistanceRank                                      },
+                { "name",         System.GetBaryName()                              },
+                { "seed",         Slot.Seed                                         },
+                { "slot_type",    std::to_underlying(Slot.Type)                     },
+                { "position",     { Slot.Position.x, Slot.Position.y, Slot.Position.z } },
+                { "planet_count", System.PlanetsData().size()                       },
+                { "stars",        std::move(Stars)                                  }
+            };
+
+            File << Record.dump() << '\n';
+        }
+    }
+
+    if (!File)
+    {
+        throw std::runtime_error(std::format("Failed to write shard file: {}", _Info.OutputFile.string()));
+    }
+
+    NpgsCoreInfo("Shard: sector {} completed, {} stellar systems written.", _Info.SectorIndex, SectorRanks.size());
+    return SectorRanks.size();
+}
+
+std::size_t FUniverseShard::Merge(const std::vector<std::filesystem::path>& ShardFiles, const std::filesystem::path& OutputFile)
+{
+    if (ShardFiles.empty())
+    {
+        throw std::invalid_argument("No shard files to merge.");
+    }
+
+    std::vector<std::unique_ptr<FShardReader>> Readers;
+    std::vector<bool> bSectorSeen;
+    std::size_t SystemCount = 0;
+
+    for (const auto& Filename : ShardFiles)
+    {
+        auto Reader = std::make_unique<FShardReader>();
+        Reader->File.open(Filename);
+        if (!Reader->File.is_open() || !std::getline(Reader->File, Reader->Line))
+        {
+            throw std::runtime_error(std::format("Failed to read shard file: {}", Filename.string()));
+        }
+
+        Reader->Header = nlohmann::json::parse(Reader->Line);
+
+        // 除扇区序号和扇区内的系统数外，所有分片的参数必须一致
+        auto Parameters = Reader->Header;
+        Parameters.erase("sector_index");
+        Parameters.erase("system_count");
+        if (!Readers.empty())
+        {
+            auto FirstParameters = Readers.front()->Header;
+            FirstParameters.erase("sector_index");
+            FirstParameters.erase("system_count");
+            if (Parameters != FirstParameters)
+            {
+                throw std::runtime_error(std::format("Shard parameters mismatch: {}", Filename.string()));
+            }
+        }
+        else
+        {
+            int SectorDepth = Reader->Header["sector_depth"].get<int>();
+            if (SectorDepth < 0 || SectorDepth > _kMaxSectorDepth)
+            {
+                throw std::runtime_error(std::format("Invalid sector depth {}: {}", SectorDepth, Filename.string()));
+            }
+
+            bSectorSeen.assign(GetSectorCount(SectorDepth), false);
+        }
+
+        std::uint32_t SectorIndex = Reader->Header["sector_index"].get<std::uint32_t>();
+        if (SectorIndex >= bSectorSeen.size() || bSectorSeen[SectorIndex])
+        {
+            throw std::runtime_error(std::format("Duplicated or invalid sector {}: {}", SectorIndex, Filename.string()));
+        }
+
+        bSectorSeen[SectorIndex] = true;
+        SystemCount += Reader->Header["system_count"].get<std::size_t>();
+        Readers.push_back(std::move(Reader));
+    }
+
+    std::size_t SlotCount = Readers.front()->Header["slot_count"].get<std::size_t>();
+    if (SystemCount != SlotCount)
+    {
+        throw std::runtime_error(std::format("Shards cover {} of {} stellar systems.", SystemCount, SlotCount));
+    }
+
+    std::ofstream File(OutputFile);
+    if (!File.is_open())
+    {
+        throw std::runtime_error(std::format("Failed to open output file: {}", OutputFile.string()));
+    }
+
+    auto Header = Readers.front()->Header;
+    Header.erase("sector_depth");
+    Header.erase("sector_index");
+    Header["system_count"] = SystemCount;
+    File << Header.dump() << '\n';
+
+    // 各分片内按排名递增，k 路归并后排名必须恰好是 0, 1, 2, ...，否则说明分片不完整或不属于同一个宇宙
+    using FHeapItem = std::pair<std::size_t, std::size_t>; // (排名, 分片下标)
+    std::priority_queue<FHeapItem, std::vector<FHeapItem>, std::greater<>> Heap;
+    for (std::size_t i = 0; i != Readers.size(); ++i)
+    {
+        if (Readers[i]->Next())
+        {
+            Heap.emplace(Readers[i]->Record["rank"].get<std::size_t>(), i);
+        }
+    }
+
+    std::size_t ExpectedRank = 0;
+    while (!Heap.empty())
+    {
+        auto [DistanceRank, ReaderIndex] = Heap.top();
+        Heap.pop();
+
+        if (DistanceRank != ExpectedRank)
+        {
+            throw std::runtime_error(std::format("Stellar system rank {} is missing or duplicated.", ExpectedRank));
+        }
+
+        auto& Reader = *Readers[ReaderIndex];
+        File << Reader.Line << '\n';
+        ++ExpectedRank;
+
+        if (Reader.Next())
+        {
+            std::size_t NextRank = Reader.Record["rank"].get<std::size_t>();
+            if (NextRank <= DistanceRank)
+            {
+                throw std::runtime_error(std::format("Shard of sector {} is not sorted by rank.",
+                                                     Reader.Header["sector_index"].get<std::uint32_t>()));
+            }
+
+            Heap.emplace(NextRank, ReaderIndex);
+        }
+    }
+
+    if (ExpectedRank != SystemCount)
+    {
+        throw std::runtime_error(std::format("Merged {} of {} stellar systems.", ExpectedRank, SystemCount));
+    }
+
+    NpgsCoreInfo("Merged {} shards into {} stellar systems.", Readers.size(), SystemCount);
+    return SystemCount;
+}
+
+std::uint32_t FUniverseShard::GetSectorCount(int SectorDepth)
+{
+    return static_cast<std::uint32_t>(1) << (3 * SectorDepth);
+}
+
+_NPGS_END
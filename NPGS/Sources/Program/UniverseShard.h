@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+
+// 按扇区分片生成。扇区是八叉树在 SectorDepth 层上的子树，共 8^SectorDepth 个，每个进程只生成一个扇区的恒星系统
+// 格子、距离排名和格子种子由全局种子在每个进程中以相同方式得到，扇区内的恒星系统与单进程生成的完全一致
+// 分片只拆分恒星系统的生成工作：格子的位置、边界裁剪、特殊星分配和种子都从同一个随机数流中按全局顺序抽取，
+// 每个进程仍要构建全部格子和八叉树，这部分内存与总恒星数成正比（每个格子约几十字节）。
+// 恒星系统本身只占用与批大小相关的内存，因此能生成的宇宙规模仍受单机存放全部格子的内存限制
+// 分片文件为 JSON Lines：第一行是生成参数，之后每行一个恒星系统，按距离排名递增。Merge 把所有分片合并为一个文件
+class FUniverseShard
+{
+public:
+    struct FShardInfo
+    {
+        std::uint32_t         Seed{};
+        std::size_t           StarCount{};
+        std::size_t           ExtraGiantCount{};
+        std::size_t           ExtraMassiveStarCount{};
+        std::size_t           ExtraNeutronStarCount{};
+        std::size_t           ExtraBlackHoleCount{};
+        std::size_t           ExtraMergeStarCount{};
+        float                 UniverseAge{ 1.38e10f };
+        int                   SectorDepth{ 1 };
+        std::uint32_t         SectorIndex{};
+        std::filesystem::path OutputFile;
+    };
+
+public:
+    explicit FUniverseShard(const FShardInfo& Info);
+    ~FUniverseShard() = default;
+
+    // 生成本扇区的恒星系统并写入 OutputFile，返回写入的恒星系统数
+    std::size_t Generate() const;
+
+    // 按距离排名归并各分片，检查参数一致、扇区不重复且覆盖全部排名，返回恒星系统总数
+    static std::size_t Merge(const std::vector<std::filesystem::path>& ShardFiles, const std::filesystem::path& OutputFile);
+    static std::uint32_t GetSectorCount(int SectorDepth);
+
+private:
+    static constexpr std::size_t _kBatchSize      = 4096; // 每批生成并写出的恒星系统数，限制内存占用
+    static constexpr std::size_t _kMinChunkSize   = 16;
+    static constexpr int         _kMaxSectorDepth = 10;   // 扇区序号用 32 位整数表示
+
+private:
+    FShardInfo _Info;
+};
+
+_NPGS_END
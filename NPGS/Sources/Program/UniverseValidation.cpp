@@ -0,0 +1,121 @@
+#include "UniverseValidation.h"
+
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "Engine/Core/Types/Entries/Astro/Star.h"
+#include "Engine/Core/Types/Entries/Astro/StellarSystem.h"
+#include "Engine/Utils/Logger.h"
+#include "Universe.h"
+
+_NPGS_BEGIN
+
+// Tool functions
+// --------------
+namespace
+{
+    void Record(FUniverseValidation::FCheckResult& Result, bool bMatched)
+    {
+        ++Result.CheckCount;
+        Result.MismatchCount += bMatched ? 0 : 1;
+    }
+
+    // 质量按位比较，任何生成顺序或线程数造成的差异都会被发现
+    bool IsSameSystem(Astro::FStellarSystem* Expected, Astro::FStellarSystem* Actual)
+    {
+        if (Expected == nullptr || Actual == nullptr)
+        {
+            return false;
+        }
+
+        if (Expected->GetBaryName() != Actual->GetBaryName() || Expected->GetBaryPosition() != Actual->GetBaryPosition())
+        {
+            return false;
+        }
+
+        const auto& ExpectedStars = Expected->StarsData();
+        const auto& ActualStars   = Actual->StarsData();
+        if (ExpectedStars.size() != ActualStars.size())
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i != ExpectedStars.size(); ++i)
+        {
+            if (ExpectedStars[i]->GetName() != ActualStars[i]->GetName() ||
+                ExpectedStars[i]->GetMass() != ActualStars[i]->GetMass())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+// UniverseValidation implementations
+// ----------------------------------
+FUniverseValidation::FUniverseValidation(const FValidationInfo& Info)
+    : _Info(Info)
+{
+}
+
+std::vector<FUniverseValidation::FCheckResult> FUniverseValidation::Run() const
+{
+    std::vector<FCheckResult> Results;
+
+    NpgsCoreInfo("Universe validation: generating reference universe...");
+    FUniverse Reference(_Info.Seed, _Info.StarCount);
+    Reference.FillUniverse();
+    std::size_t SlotCount = Reference.GetSlotCount();
+
+    // 焦点取在中间排名的恒星系统上，渐进式生成的顺序与距离排名明显不同
+    glm::vec3 FocusPosition(0.0f);
+    if (SlotCount != 0)
+    {
+        FocusPosition = Reference.GetStellarSystem(SlotCount / 2)->GetBaryPosition();
+    }
+
+    {
+        NpgsCoreInfo("Universe validation: comparing progressive generation...");
+        FCheckResult Result{ .Name = "Progressive" };
+        FUniverse Universe(_Info.Seed, _Info.StarCount);
+        Universe.FillUniverseProgressive(_Info.NearFieldSystemCount, FocusPosition);
+        Universe.WaitForCompletion();
+
+        Record(Result, Universe.GetSlotCount() == SlotCount);
+        for (std::size_t i = 0; i != SlotCount; ++i)
+        {
+            Record(Result, IsSameSystem(Reference.GetStellarSystem(i), Universe.GetStellarSystem(i)));
+        }
+
+        Results.push_back(std::move(Result));
+    }
+
+    {
+        // 每个系统比较后立即释放，再生成一次后仍然相同，常驻内存的系统始终只有一个
+        NpgsCoreInfo("Universe validation: comparing on-demand generation...");
+        FCheckResult Result{ .Name = "OnDemand" };
+        FCheckResult RematerializeResult{ .Name = "OnDemandRematerialize" };
+        FUniverse Universe(_Info.Seed, _Info.StarCount);
+        Universe.FillUniverseOnDemand();
+
+        Record(Result, Universe.GetSlotCount() == SlotCount);
+        for (std::size_t i = 0; i != SlotCount; ++i)
+        {
+            Record(Result, IsSameSystem(Reference.GetStellarSystem(i), Universe.GetStellarSystem(i)));
+            Universe.ReleaseStellarSystem(i);
+            Record(RematerializeResult, IsSameSystem(Reference.GetStellarSystem(i), Universe.GetStellarSystem(i)));
+            Universe.ReleaseStellarSystem(i);
+        }
+
+        Record(RematerializeResult, Universe.GetMaterializedSystemCount() == 0);
+        Results.push_back(std::move(Result));
+        Results.push_back(std::move(RematerializeResult));
+    }
+
+    return Results;
+}
+
+_NPGS_END
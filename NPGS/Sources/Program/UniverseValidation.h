@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Engine/Core/Base/Base.h"
+
+_NPGS_BEGIN
+
+// 用同一个种子分别以完整、渐进式和按需三种方式生成宇宙，逐个恒星系统比较名字、位置和每颗恒星的名字与质量
+// 三种方式共用逐格子的生成步骤，结果必须完全相同。不依赖窗口，可以在命令行中运行
+class FUniverseValidation
+{
+public:
+    struct FValidationInfo
+    {
+        std::uint32_t Seed{};
+        std::size_t   StarCount{};
+        std::size_t   NearFieldSystemCount{}; // 渐进式生成时同步生成的恒星系统数
+    };
+
+    struct FCheckResult
+    {
+        std::string Name;
+        std::size_t CheckCount{};    // 比较的恒星系统数
+        std::size_t MismatchCount{}; // 与完整生成不一致的恒星系统数
+    };
+
+public:
+    explicit FUniverseValidation(const FValidationInfo& Info);
+    ~FUniverseValidation() = default;
+
+    std::vector<FCheckResult> Run() const;
+
+private:
+    FValidationInfo _Info;
+};
+
+_NPGS_END
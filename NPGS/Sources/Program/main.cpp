@@ -1,14 +1,311 @@
 #define GLM_FORCE_ALIGNED_GENTYPES
 #include "Npgs.h"
 #include "Application.h"
+#include "OctreeValidation.h"
+#include "ThreadValidation.h"
+#include "UniverseBenchmark.h"
+#include "UniverseEnsemble.h"
+#include "UniverseShard.h"
+#include "UniverseValidation.h"
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace Npgs;
 using namespace Npgs::Util;
 
-int main()
+// 无窗口运行阶段基准测试：
+// NPGS --benchmark [StarCount] [Seed] [ThreadCount] [OutputFile]
+int RunBenchmark(int argc, char** argv)
+{
+    constexpr std::string_view kUsage = "Usage: NPGS --benchmark [StarCount] [Seed] [ThreadCount] [OutputFile]";
+
+    try
+    {
+        FUniverseBenchmark::FBenchmarkInfo BenchmarkInfo
+        {
+            .Seed        = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 42u,
+            .StarCount   = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 100000,
+            .ThreadCount = argc > 4 ? std::stoi(argv[4]) : 0
+        };
+
+        // 先打开输出文件，路径无效时不必等到基准测试结束才失败
+        std::ofstream OutputFile;
+        if (argc > 5)
+        {
+            OutputFile.open(argv[5]);
+            if (!OutputFile.is_open())
+            {
+                std::println(stderr, "Failed to open benchmark output file: {}", argv[5]);
+                return 1;
+            }
+        }
+
+        FUniverseBenchmark Benchmark(BenchmarkInfo);
+        std::string Json = FUniverseBenchmark::ToJson(Benchmark.Run()).dump(4);
+        std::println("{}", Json);
+
+        if (OutputFile.is_open())
+        {
+            OutputFile << Json << std::endl;
+            if (!OutputFile.good())
+            {
+                std::println(stderr, "Failed to write benchmark output file: {}", argv[5]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Benchmark failed: {}", Exception.what());
+        std::println(stderr, "{}", kUsage);
+        return 1;
+    }
+
+    return 0;
+}
+
+// 无窗口生成多个连续种子并输出每个种子和合计的统计：
+// NPGS --ensemble [StarCount] [FirstSeed] [SeedCount]
+int RunEnsemble(int argc, char** argv)
+{
+    try
+    {
+        std::uint32_t FirstSeed = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 42u;
+        std::uint32_t SeedCount = argc > 4 ? static_cast<std::uint32_t>(std::stoul(argv[4])) : 8u;
+
+        FUniverseEnsemble::FEnsembleInfo EnsembleInfo
+        {
+            .StarCount = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 100000
+        };
+
+        for (std::uint32_t i = 0; i != SeedCount; ++i)
+        {
+            EnsembleInfo.Seeds.push_back(FirstSeed + i);
+        }
+
+        FUniverseEnsemble Ensemble(EnsembleInfo);
+        auto Result = Ensemble.Run();
+
+        for (const auto& SeedResult : Result.SeedResults)
+        {
+            std::println("Seed {}:", SeedResult.Seed);
+            FStellarStatistics::Print(SeedResult.Statistics);
+        }
+
+        std::println("Aggregate of {} seeds, {:.3f} s:", Result.SeedResults.size(), Result.TotalSeconds);
+        FStellarStatistics::Print(Result.Aggregate);
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Ensemble generation failed: {}", Exception.what());
+        std::println(stderr, "Usage: NPGS --ensemble [StarCount] [FirstSeed] [SeedCount]");
+        return 1;
+    }
+
+    return 0;
+}
+
+// 生成一个扇区并写入分片文件，扇区共 8^SectorDepth 个。分片只拆分恒星系统的生成，每个进程仍构建全部格子：
+// NPGS --shard StarCount Seed SectorDepth SectorIndex OutputFile
+int RunShard(int argc, char** argv)
+{
+    constexpr std::string_view kUsage = "Usage: NPGS --shard StarCount Seed SectorDepth SectorIndex OutputFile";
+    if (argc < 7)
+    {
+        std::println("{}", kUsage);
+        return 1;
+    }
+
+    // 参数解析失败、扇区参数无效或文件无法写入时都以非零值退出
+    try
+    {
+        FUniverseShard::FShardInfo ShardInfo
+        {
+            .Seed        = static_cast<std::uint32_t>(std::stoul(argv[3])),
+            .StarCount   = static_cast<std::size_t>(std::stoull(argv[2])),
+            .SectorDepth = std::stoi(argv[4]),
+            .SectorIndex = static_cast<std::uint32_t>(std::stoul(argv[5])),
+            .OutputFile  = argv[6]
+        };
+
+        FUniverseShard Shard(ShardInfo);
+        Shard.Generate();
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Shard generation failed: {}", Exception.what());
+        std::println(stderr, "{}", kUsage);
+        return 1;
+    }
+
+    return 0;
+}
+
+// 把全部扇区的分片文件合并为一个文件：
+// NPGS --merge OutputFile ShardFile...
+int RunMerge(int argc, char** argv)
+{
+    constexpr std::string_view kUsage = "Usage: NPGS --merge OutputFile ShardFile...";
+    if (argc < 4)
+    {
+        std::println("{}", kUsage);
+        return 1;
+    }
+
+    try
+    {
+        std::vector<std::filesystem::path> ShardFiles(argv + 3, argv + argc);
+        FUniverseShard::Merge(ShardFiles, argv[2]);
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Shard merge failed: {}", Exception.what());
+        std::println(stderr, "{}", kUsage);
+        return 1;
+    }
+
+    return 0;
+}
+
+// 用随机位置点检查八叉树的构建和查询，与暴力计算不一致时返回 1：
+// NPGS --validate-octree [PointCount] [Seed] [QueryCount]
+int RunOctreeValidation(int argc, char** argv)
+{
+    std::size_t MismatchCount = 0;
+    try
+    {
+        FOctreeValidation::FValidationInfo ValidationInfo
+        {
+            .Seed       = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 42u,
+            .PointCount = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 100000,
+            .QueryCount = argc > 4 ? static_cast<std::size_t>(std::stoull(argv[4])) : 1000
+        };
+
+        FOctreeValidation Validation(ValidationInfo);
+        for (const auto& Result : Validation.Run())
+        {
+            std::println("{}: {} checks, {} mismatches", Result.Name, Result.CheckCount, Result.MismatchCount);
+            MismatchCount += Result.MismatchCount;
+        }
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Octree validation failed: {}", Exception.what());
+        std::println(stderr, "Usage: NPGS --validate-octree [PointCount] [Seed] [QueryCount]");
+        return 1;
+    }
+
+    return MismatchCount == 0 ? 0 : 1;
+}
+
+// 检查线程池、任务内存池、并行循环和任务依赖图，与预期不一致时返回 1：
+// NPGS --validate-threads [TaskCount] [Seed] [RestartCount]
+int RunThreadValidation(int argc, char** argv)
+{
+    std::size_t MismatchCount = 0;
+    try
+    {
+        FThreadValidation::FValidationInfo ValidationInfo
+        {
+            .Seed         = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 42u,
+            .TaskCount    = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 4096,
+            .RestartCount = argc > 4 ? static_cast<std::size_t>(std::stoull(argv[4])) : 64
+        };
+
+        FThreadValidation Validation(ValidationInfo);
+        for (const auto& Result : Validation.Run())
+        {
+            std::println("{}: {} checks, {} mismatches", Result.Name, Result.CheckCount, Result.MismatchCount);
+            MismatchCount += Result.MismatchCount;
+        }
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Thread validation failed: {}", Exception.what());
+        std::println(stderr, "Usage: NPGS --validate-threads [TaskCount] [Seed] [RestartCount]");
+        return 1;
+    }
+
+    return MismatchCount == 0 ? 0 : 1;
+}
+
+// 用同一个种子比较完整、渐进式和按需生成的每个恒星系统，不一致时返回 1：
+// NPGS --validate-universe [StarCount] [Seed] [NearFieldSystemCount]
+int RunUniverseValidation(int argc, char** argv)
+{
+    std::size_t MismatchCount = 0;
+    try
+    {
+        FUniverseValidation::FValidationInfo ValidationInfo
+        {
+            .Seed                 = argc > 3 ? static_cast<std::uint32_t>(std::stoul(argv[3])) : 42u,
+            .StarCount            = argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 20000,
+            .NearFieldSystemCount = argc > 4 ? static_cast<std::size_t>(std::stoull(argv[4])) : 1024
+        };
+
+        FUniverseValidation Validation(ValidationInfo);
+        for (const auto& Result : Validation.Run())
+        {
+            std::println("{}: {} checks, {} mismatches", Result.Name, Result.CheckCount, Result.MismatchCount);
+            MismatchCount += Result.MismatchCount;
+        }
+    }
+    catch (const std::exception& Exception)
+    {
+        std::println(stderr, "Universe validation failed: {}", Exception.what());
+        std::println(stderr, "Usage: NPGS --validate-universe [StarCount] [Seed] [NearFieldSystemCount]");
+        return 1;
+    }
+
+    return MismatchCount == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
 {
     FLogger::Initialize();
 
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark")
+    {
+        return RunBenchmark(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--ensemble")
+    {
+        return RunEnsemble(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--shard")
+    {
+        return RunShard(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--merge")
+    {
+        return RunMerge(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--validate-octree")
+    {
+        return RunOctreeValidation(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--validate-threads")
+    {
+        return RunThreadValidation(argc, argv);
+    }
+
+    if (argc > 1 && std::string_view(argv[1]) == "--validate-universe")
+    {
+        return RunUniverseValidation(argc, argv);
+    }
+
     FApplication App({ 1280, 960 }, "Learn glNext FPS:", false, false);
     App.ExecuteMainRender();
     return 0;